@@ -19,8 +19,6 @@
 #include "LRAS1130.h"
 
 
-#include <Arduino.h>
-
 #include <cstring>
 
 
@@ -36,14 +34,24 @@
 /// @section requirements_sec Requirements
 ///
 /// This library is writte for Arduino compatible chips. It requires a 
-/// modern C++ compiler (C++11). The code also uses the "Wire" library 
+/// modern C++ compiler (C++11). By default, the code uses the "Wire" library 
 /// from the Arduino project for the I2C communication.
 ///
 /// @section classes_sec Classes
 ///
-/// There is only the lr::AS1130 class. Read the documentation of this class
+/// The main class is lr::AS1130. Read the documentation of this class
 /// for all details.
 ///
+/// The I2C communication is done using the lr::AS1130Bus interface. The
+/// class lr::AS1130WireBus implements this interface using the "Wire" library.
+/// On Linux hosts, the class lr::AS1130LinuxBus uses the i2c-dev interface.
+///
+/// To run the driver without hardware, attach one or more lr::AS1130SimulatedChip
+/// instances to a lr::AS1130SimulatorBus.
+///
+/// Frames can be converted at compile time using lr::AS1130Frame. With a
+/// lr::AS1130MemoryCache, the driver only sends changed bytes to the chip.
+///
 
 
 /// @brief The namespace for all Lucky Resistor classes and types.
@@ -58,23 +66,77 @@ namespace {
 ///
 const uint8_t cRegisterSelectionAddress = 0xfd;
 
+/// The value used if the current register selection is unknown.
+///
+/// This is no valid register selection value, so the next access will always
+/// write the register selection to the chip.
+///
+const uint8_t cRegisterSelectionUnknown = 0xff;
+
+/// The maximum number of messages passed to the bus in one transfer.
+///
+const uint8_t cMaximumMessageCount = 8;
+
+/// The size of the buffer used to fill memory with the same value.
+///
+const uint8_t cFillBufferSize = 0x20;
+
+/// The maximum number of unchanged bytes between two runs of changed bytes
+/// which are merged into one message.
+///
+/// A separate message costs at least the chip address and the register address,
+/// so resending up to two unchanged bytes is never more expensive.
+///
+const uint8_t cMaximumMergeGap = 2;
+
+/// The number of control registers kept in the shadow copy.
+///
+const uint8_t cControlRegisterShadowSize = AS1130::CR_ClockSynchronization + 1;
+
+/// The size of one on/off frame or the blink part of a blink&PWM set.
+///
+const uint8_t cFrameSize = 0x18;
+
+/// The number of PWM values in a blink&PWM set.
+///
+const uint8_t cPwmValueCount = 0x84;
+
   
 }
 
 
 
+#if defined(ARDUINO)
 AS1130::AS1130(ChipAddress chipAddress)
-  : _chipAddress(chipAddress)
+  : AS1130(AS1130WireBus::defaultBus(), chipAddress)
 {
 }
+#endif
+
+
+AS1130::AS1130(AS1130Bus &bus, ChipAddress chipAddress)
+  : _bus(&bus), _chipAddress(chipAddress), _registerSelection(cRegisterSelectionUnknown), _isControlRegisterShadowEnabled(false), _memoryCache(nullptr)
+{
+  std::memset(_controlRegisterShadow, 0, cControlRegisterShadowSize);
+  resetStatistics();
+}
 
 
 bool AS1130::isChipConnected()
 {
-  Wire.beginTransmission(_chipAddress); 
-  Wire.write(cRegisterSelectionAddress); 
-  Wire.write(RS_NOP); 
-  return Wire.endTransmission() == 0; 
+#if defined(LRAS1130_STATISTICS)
+  const uint32_t startTime = _bus->getTimeUs();
+#endif
+  // The probe bypasses queuing buses, the answer of the chip is required now.
+  const bool success = _bus->probe(_chipAddress);
+#if defined(LRAS1130_STATISTICS)
+  const AS1130Bus::Message message = AS1130Bus::Message::write(cRegisterSelectionAddress, nullptr, 0);
+  updateStatistics(&message, 1, success, _bus->getTimeUs() - startTime);
+#endif
+  if (!success) {
+    invalidateRegisterSelection();
+  }
+  return success;
 }
 
 
@@ -86,92 +148,220 @@ void AS1130::setRamConfiguration(RamConfiguration ramConfiguration)
 
 namespace {
 
-// Set the LED in the frame register.
-//
-inline void setOnOffFrameBit(uint8_t index, uint8_t *data) {
-  const uint8_t segmentIndex = (index/10);
-  const uint8_t segmentLed = (index%10);
-  const uint8_t bitToSet = (1<<(segmentLed&0x7));
-  uint8_t *target = data + (segmentIndex*2);
-  if (segmentLed >= 8) {
-    ++target;
-  }
-  *target |= bitToSet;
-}
-
-// Check if in the definition bit mask a bit at the given coordinates is set.
+// Table to spread the four bits of a nibble into the lowest bit of four bytes.
+// The highest bit of the nibble, which is the leftmost column, is moved into the lowest byte.
 //
-inline bool isMaskBitSet(uint8_t x, uint8_t y, const uint8_t *data) {
-  const uint8_t *source = data + (y*3) + (x>>3);
-  const uint8_t bitToTest = (1<<(7-(x&7)));
-  return (*source & bitToTest) != 0;
-}
+const uint32_t cNibbleToLanes[16] = {
+  0x00000000, 0x01000000, 0x00010000, 0x01010000,
+  0x00000100, 0x01000100, 0x00010100, 0x01010100,
+  0x00000001, 0x01000001, 0x00010001, 0x01010001,
+  0x00000101, 0x01000101, 0x00010101, 0x01010101};
 
 }
 
 
-void AS1130::setOnOffFrame24x5(uint8_t frameIndex, const uint8_t *data, uint8_t pwmSetIndex)
+void AS1130::encodeFrame24x5(const uint8_t *data, uint8_t *frameData, uint8_t pwmSetIndex)
 {
-  // Prepare all frame bytes.
-  const uint8_t finalDataSize = 0x18;
-  uint8_t finalData[finalDataSize];
-  std::memset(finalData, 0, finalDataSize);
-  finalData[1] = (pwmSetIndex<<5);
+  // Spread each row into four columns at once, collecting the five bits
+  // of each column in one byte of a 32bit word.
+  uint32_t columns[6] = {0, 0, 0, 0, 0, 0};
   for (uint8_t y = 0; y < 5; ++y) {
-    for (uint8_t x = 0; x < 24; ++x) {
-      const uint8_t ledIndex = y + (5 * x);
-      if (isMaskBitSet(x, y, data)) {
-        setOnOffFrameBit(ledIndex, finalData);
-      }
+    const uint8_t *row = data + (y*3);
+    for (uint8_t i = 0; i < 3; ++i) {
+      columns[i*2] |= (cNibbleToLanes[row[i]>>4] << y);
+      columns[i*2+1] |= (cNibbleToLanes[row[i]&0xf] << y);
     }
   }
-  // Write the bytes
-  const uint8_t frameAddress = (RS_OnOffFrame + frameIndex);
-  for (uint8_t i = 0; i < finalDataSize; ++i) {
-    writeToMemory(frameAddress, i, finalData[i]);
+  // Each segment contains two columns with five LEDs.
+  for (uint8_t segment = 0; segment < 12; ++segment) {
+    const uint32_t lanes = columns[segment>>1];
+    const uint8_t laneShift = ((segment & 0x1) * 16);
+    const uint16_t segmentBits = static_cast<uint16_t>(((lanes >> laneShift) & 0x1f) | (((lanes >> (laneShift + 8)) & 0x1f) << 5));
+    frameData[segment*2] = static_cast<uint8_t>(segmentBits);
+    frameData[segment*2+1] = static_cast<uint8_t>(segmentBits >> 8);
+  }
+  frameData[1] |= (pwmSetIndex<<5);
+}
+
+
+void AS1130::encodeFrame12x11(const uint8_t *data, uint8_t *frameData, uint8_t pwmSetIndex)
+{
+  // Spread each row into four columns at once, collecting the bits
+  // of each column in one byte of a 32bit word.
+  uint32_t lowRows[3] = {0, 0, 0}; // Rows 0-7 for the columns 0-3, 4-7 and 8-11.
+  uint32_t highRows[3] = {0, 0, 0}; // Rows 8-10 for the columns 0-3, 4-7 and 8-11.
+  for (uint8_t y = 0; y < 11; ++y) {
+    const uint8_t *row = data + (y*2);
+    uint32_t *target = (y < 8 ? lowRows : highRows);
+    const uint8_t shift = (y & 0x7);
+    target[0] |= (cNibbleToLanes[row[0]>>4] << shift);
+    target[1] |= (cNibbleToLanes[row[0]&0xf] << shift);
+    target[2] |= (cNibbleToLanes[row[1]>>4] << shift);
+  }
+  for (uint8_t x = 0; x < 12; ++x) {
+    const uint8_t laneShift = ((x & 0x3) * 8);
+    frameData[x*2] = static_cast<uint8_t>(lowRows[x>>2] >> laneShift);
+    frameData[x*2+1] = static_cast<uint8_t>(highRows[x>>2] >> laneShift);
   }
+  frameData[1] |= (pwmSetIndex<<5);
+}
+
+
+void AS1130::setOnOffFrame24x5(uint8_t frameIndex, const uint8_t *data, uint8_t pwmSetIndex)
+{
+  uint8_t finalData[cFrameSize];
+  encodeFrame24x5(data, finalData, pwmSetIndex);
+  writeMemoryBlock(RS_OnOffFrame + frameIndex, 0, finalData, cFrameSize);
+}
+
+
+void AS1130::setOnOffFrame12x11(uint8_t frameIndex, const uint8_t *data, uint8_t pwmSetIndex)
+{
+  uint8_t finalData[cFrameSize];
+  encodeFrame12x11(data, finalData, pwmSetIndex);
+  writeMemoryBlock(RS_OnOffFrame + frameIndex, 0, finalData, cFrameSize);
+}
+
+
+void AS1130::setOnOffFrame(uint8_t frameIndex, const AS1130Frame &frame)
+{
+  writeMemoryBlock(RS_OnOffFrame + frameIndex, 0, frame.data, cFrameSize);
 }
 
 
 void AS1130::setOnOffFrameAllOn(uint8_t frameIndex, uint8_t pwmSetIndex)
 {
-  const uint8_t frameAddress = (RS_OnOffFrame + frameIndex);
-  // Write the first segment with the PWM set index.
-  writeToMemory(frameAddress, 0, 0xff);
-  writeToMemory(frameAddress, 1, (pwmSetIndex<<5)|0x03);
-  // Write all other segments 
-  for (uint8_t i = 1; i < 12; ++i) {
-    writeToMemory(frameAddress, i*2, 0xff);
-    writeToMemory(frameAddress, i*2+1, 0x07);
+  uint8_t finalData[cFrameSize];
+  for (uint8_t i = 0; i < 12; ++i) {
+    finalData[i*2] = 0xff;
+    finalData[i*2+1] = 0x07;
   }
+  // The first segment contains the PWM set index.
+  finalData[1] = (pwmSetIndex<<5)|0x03;
+  writeMemoryBlock(RS_OnOffFrame + frameIndex, 0, finalData, cFrameSize);
 }
 
 
 void AS1130::setBlinkAndPwmSetAll(uint8_t setIndex, bool doesBlink, uint8_t pwmValue)
 {
   const uint8_t setAddress = (RS_BlinkAndPwmSet + setIndex);
-  // Disable all blink flags.
+  // Set all blink flags.
+  uint8_t blinkData[cFrameSize];
   for (uint8_t i = 0; i < 12; ++i) {
     if (doesBlink) {
-      writeToMemory(setAddress, i*2, 0xff);
-      writeToMemory(setAddress, i*2+1, 0x07);
+      blinkData[i*2] = 0xff;
+      blinkData[i*2+1] = 0x07;
     } else {
-      writeToMemory(setAddress, i*2, 0x00);
-      writeToMemory(setAddress, i*2+1, 0x00);
+      blinkData[i*2] = 0x00;
+      blinkData[i*2+1] = 0x00;
+    }
+  }
+  writeMemoryBlock(setAddress, 0, blinkData, cFrameSize);
+  // Set all PWM values.
+  fillMemoryBlock(setAddress, cFrameSize, pwmValue, cPwmValueCount);
+}
+
+
+namespace {
+
+// The offset of the first PWM value for each column of a 24x5 matrix.
+//
+// Each segment contains two columns with five LEDs.
+//
+const uint8_t cPwmColumnOffsets24x5[24] = {
+  0, 5, 11, 16, 22, 27, 33, 38, 44, 49, 55, 60,
+  66, 71, 77, 82, 88, 93, 99, 104, 110, 115, 121, 126};
+
+// The offset of the first PWM value for each column of a 12x11 matrix.
+//
+// Each column is one segment.
+//
+const uint8_t cPwmColumnOffsets12x11[12] = {
+  0, 11, 22, 33, 44, 55, 66, 77, 88, 99, 110, 121};
+
+}
+
+
+void AS1130::setBlinkMask24x5(uint8_t setIndex, const uint8_t *data)
+{
+  uint8_t blinkData[cFrameSize];
+  encodeFrame24x5(data, blinkData);
+  writeMemoryBlock(RS_BlinkAndPwmSet + setIndex, 0, blinkData, cFrameSize);
+}
+
+
+void AS1130::setBlinkMask12x11(uint8_t setIndex, const uint8_t *data)
+{
+  uint8_t blinkData[cFrameSize];
+  encodeFrame12x11(data, blinkData);
+  writeMemoryBlock(RS_BlinkAndPwmSet + setIndex, 0, blinkData, cFrameSize);
+}
+
+
+void AS1130::setBlinkMask(uint8_t setIndex, const AS1130Frame &frame)
+{
+  writeMemoryBlock(RS_BlinkAndPwmSet + setIndex, 0, frame.data, cFrameSize);
+}
+
+
+void AS1130::setPwmValues(uint8_t setIndex, const uint8_t *values)
+{
+  writeMemoryBlock(RS_BlinkAndPwmSet + setIndex, cFrameSize, values, cPwmValueCount);
+}
+
+
+void AS1130::setPwmValues24x5(uint8_t setIndex, const uint8_t *values)
+{
+  uint8_t pwmValues[cPwmValueCount];
+  std::memset(pwmValues, 0, cPwmValueCount);
+  for (uint8_t x = 0; x < 24; ++x) {
+    uint8_t *target = pwmValues + cPwmColumnOffsets24x5[x];
+    for (uint8_t y = 0; y < 5; ++y) {
+      target[y] = values[y*24+x];
+    }
+  }
+  setPwmValues(setIndex, pwmValues);
+}
+
+
+void AS1130::setPwmValues12x11(uint8_t setIndex, const uint8_t *values)
+{
+  uint8_t pwmValues[cPwmValueCount];
+  for (uint8_t x = 0; x < 12; ++x) {
+    uint8_t *target = pwmValues + cPwmColumnOffsets12x11[x];
+    for (uint8_t y = 0; y < 11; ++y) {
+      target[y] = values[y*12+x];
     }
   }
-  // Set all PWM values to the maximum.
-  for (uint8_t i = 0x18; i < 0x9c; ++i) {
-    writeToMemory(setAddress, i, pwmValue);
+  setPwmValues(setIndex, pwmValues);
+}
+
+
+void AS1130::setPwmValuesRect24x5(uint8_t setIndex, uint8_t x, uint8_t y, uint8_t width, uint8_t height, const uint8_t *values)
+{
+  if (x >= 24 || y >= 5) {
+    return;
   }
+  const uint8_t columnCount = (width > 24 - x ? 24 - x : width);
+  const uint8_t rowCount = (height > 5 - y ? 5 - y : height);
+  writePwmColumns(setIndex, cPwmColumnOffsets24x5, x, y, columnCount, rowCount, width, values);
 }
 
 
-void AS1130::setDotCorrection(const uint8_t *data)
+void AS1130::setPwmValuesRect12x11(uint8_t setIndex, uint8_t x, uint8_t y, uint8_t width, uint8_t height, const uint8_t *values)
 {
-  for (uint8_t i = 0; i < 12; ++i) {
-    writeToMemory(RS_DotCorrection, i, data[i]);
+  if (x >= 12 || y >= 11) {
+    return;
   }
+  const uint8_t columnCount = (width > 12 - x ? 12 - x : width);
+  const uint8_t rowCount = (height > 11 - y ? 11 - y : height);
+  writePwmColumns(setIndex, cPwmColumnOffsets12x11, x, y, columnCount, rowCount, width, values);
+}
+
+
+void AS1130::setDotCorrection(const uint8_t *data)
+{
+  writeMemoryBlock(RS_DotCorrection, 0, data, 12);
 }
 
 
@@ -363,32 +553,122 @@ void AS1130::stopChip()
 }
 
 
+void AS1130::resetChip()
+{
+  writeControlRegister(CR_ShutdownAndOpenShort, 0x00);
+  _bus->delayMs(1);
+  writeControlRegister(CR_ShutdownAndOpenShort, SOSF_Initialize);
+  _bus->delayMs(1);
+  // The reset restores the default register selection, control registers and memory.
+  invalidateCachedState();
+}
+
+
 void AS1130::runManualTest()
 {
   setControlRegisterBits(CR_ShutdownAndOpenShort, SOSF_ManualTest);
   while (isLedTestRunning()) {
-    delay(10);
+    _bus->delayMs(10);
   }
   clearControlRegisterBits(CR_ShutdownAndOpenShort, SOSF_ManualTest);
 }
 
 
+namespace {
+
+// Check if the LED index is a valid LED of the chip.
+//
+inline bool isLedIndexValid(uint8_t ledIndex) {
+  return ledIndex <= 0xba && (ledIndex & 0x0f) <= 0xa;
+}
+
+// Get the LED status from the content of an open LED register.
+//
+inline AS1130::LedStatus getLedStatusFromRegister(uint8_t ledIndex, uint8_t registerData) {
+  const uint8_t ledBitMask = (1<<(ledIndex&0x7));
+  if ((registerData & ledBitMask) == 0) {
+    return AS1130::LedStatusOpen;
+  } else {
+    return AS1130::LedStatusOk;
+  }
+}
+
+}
+
+
 AS1130::LedStatus AS1130::getLedStatus(uint8_t ledIndex)
 {
-  if (ledIndex > 0xba) {
+  if (!isLedIndexValid(ledIndex)) {
     return LedStatusDisabled;
   }
-  if ((ledIndex & 0x0f) > 0xa) {
+  const uint8_t registerIndex = CR_OpenLedBase + (ledIndex>>3);
+  return getLedStatusFromRegister(ledIndex, readFromMemory(RS_Control, registerIndex));
+}
+
+
+void AS1130::readLedStatusMap(LedStatusMap &ledStatusMap)
+{
+  readMemoryBlock(RS_Control, CR_OpenLedBase, ledStatusMap.data, sizeof(ledStatusMap.data));
+}
+
+
+uint8_t AS1130::getLedIndex24x5(uint8_t x, uint8_t y)
+{
+  const uint8_t ledIndex = y + (5 * x);
+  return ((ledIndex/10)<<4) | (ledIndex%10);
+}
+
+
+uint8_t AS1130::getLedIndex12x11(uint8_t x, uint8_t y)
+{
+  return (x<<4) | y;
+}
+
+
+uint8_t AS1130::getPwmAddress(uint8_t ledIndex)
+{
+  return cFrameSize + ((ledIndex>>4) * 11) + (ledIndex&0x0f);
+}
+
+
+AS1130::LedStatus AS1130::LedStatusMap::getLedStatus(uint8_t ledIndex) const
+{
+  if (!isLedIndexValid(ledIndex)) {
     return LedStatusDisabled;
   }
-  const uint8_t ledBitMask = (1<<(ledIndex&0x7));
-  const uint8_t registerIndex = CR_OpenLedBase + (ledIndex>>3);
-  const uint8_t mask = readFromMemory(RS_Control, registerIndex);
-  if ((mask & ledBitMask) == 0) {
-    return LedStatusOpen;
-  } else {
-    return LedStatusOk;
+  return getLedStatusFromRegister(ledIndex, data[ledIndex>>3]);
+}
+
+
+AS1130::LedStatus AS1130::LedStatusMap::getLedStatus24x5(uint8_t x, uint8_t y) const
+{
+  if (x >= 24 || y >= 5) {
+    return LedStatusDisabled;
+  }
+  return getLedStatus(getLedIndex24x5(x, y));
+}
+
+
+AS1130::LedStatus AS1130::LedStatusMap::getLedStatus12x11(uint8_t x, uint8_t y) const
+{
+  if (x >= 12 || y >= 11) {
+    return LedStatusDisabled;
+  }
+  return getLedStatus(getLedIndex12x11(x, y));
+}
+
+
+uint8_t AS1130::LedStatusMap::getOpenLedCount() const
+{
+  uint8_t count = 0;
+  for (uint8_t segment = 0; segment < 12; ++segment) {
+    for (uint8_t led = 0; led < 11; ++led) {
+      if (getLedStatus((segment<<4)|led) == LedStatusOpen) {
+        ++count;
+      }
+    }
   }
+  return count;
 }
 
 
@@ -415,39 +695,285 @@ uint8_t AS1130::getDisplayedFrame()
 
 uint8_t AS1130::getInterruptStatus()
 {
-  return readControlRegister(CR_InterruptStatus);
+  // A power on reset sets the register selection of the chip back to RS_NOP,
+  // so the cached selection can not be trusted for this read.
+  invalidateRegisterSelection();
+  const uint8_t data = readControlRegister(CR_InterruptStatus);
+  if ((data & IMF_POR) != 0) {
+    // After a power on reset, the memory and registers of the chip are cleared.
+    invalidateCachedState();
+  }
+  return data;
 }
 
 
 void AS1130::writeToChip(uint8_t address, uint8_t data)
 {
-  Wire.beginTransmission(_chipAddress); 
-  Wire.write(address); 
-  Wire.write(data); 
-  Wire.endTransmission(); 
+  const AS1130Bus::Message message = AS1130Bus::Message::write(address, &data, 1);
+  transfer(&message, 1);
+}
+
+
+void AS1130::selectRegister(uint8_t registerSelection)
+{
+  if (_registerSelection != registerSelection) {
+    writeToChip(cRegisterSelectionAddress, registerSelection);
+  }
+}
+
+
+void AS1130::invalidateRegisterSelection()
+{
+  _registerSelection = cRegisterSelectionUnknown;
+}
+
+
+void AS1130::invalidateCachedState()
+{
+  invalidateRegisterSelection();
+  if (_isControlRegisterShadowEnabled) {
+    syncShadowFromChip();
+  }
+  if (_memoryCache != nullptr) {
+    _memoryCache->invalidate();
+  }
+}
+
+
+AS1130Bus& AS1130::getBus() const
+{
+  return *_bus;
+}
+
+
+AS1130::ChipAddress AS1130::getChipAddress() const
+{
+  return static_cast<ChipAddress>(_chipAddress);
+}
+
+
+bool AS1130::transfer(const AS1130Bus::Message *messages, uint8_t count)
+{
+#if defined(LRAS1130_STATISTICS)
+  const uint32_t startTime = _bus->getTimeUs();
+#endif
+  const bool success = _bus->transfer(_chipAddress, messages, count);
+#if defined(LRAS1130_STATISTICS)
+  updateStatistics(messages, count, success, _bus->getTimeUs() - startTime);
+#endif
+  if (!success) {
+    invalidateRegisterSelection();
+    return false;
+  }
+  for (uint8_t i = 0; i < count; ++i) {
+    const AS1130Bus::Message &message = messages[i];
+    if (!message.isRead && message.registerAddress == cRegisterSelectionAddress && message.length == 1) {
+      _registerSelection = message.writeData[0];
+    }
+  }
+  return true;
+}
+
+
+uint8_t AS1130::prepareRegisterSelection(AS1130Bus::Message *message, const uint8_t *registerSelection)
+{
+  if (_registerSelection == *registerSelection) {
+    return 0;
+  }
+  *message = AS1130Bus::Message::write(cRegisterSelectionAddress, registerSelection, 1);
+  return 1;
+}
+
+
+bool AS1130::writeMemoryMessages(uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint16_t length, bool repeatData)
+{
+  uint16_t maximumLength = _bus->getMaximumDataLength();
+  if (repeatData && maximumLength > cFillBufferSize) {
+    maximumLength = cFillBufferSize;
+  }
+  AS1130Bus::Message messages[cMaximumMessageCount];
+  uint8_t count = prepareRegisterSelection(messages, &registerSelection);
+  while (length > 0) {
+    const uint16_t messageLength = (length > maximumLength ? maximumLength : length);
+    messages[count++] = AS1130Bus::Message::write(startAddress, data, messageLength);
+    startAddress += messageLength;
+    if (!repeatData) {
+      data += messageLength;
+    }
+    length -= messageLength;
+    if (count == cMaximumMessageCount || length == 0) {
+      if (!transfer(messages, count)) {
+        return false;
+      }
+      count = 0;
+    }
+  }
+  return true;
+}
+
+
+void AS1130::setControlRegisterShadowEnabled(bool enabled)
+{
+  _isControlRegisterShadowEnabled = enabled;
+  if (enabled) {
+    syncShadowFromChip();
+  }
+}
+
+
+void AS1130::syncShadowFromChip()
+{
+  readMemoryBlock(RS_Control, CR_Picture, _controlRegisterShadow, cControlRegisterShadowSize);
+}
+
+
+void AS1130::updateControlRegisterShadow(uint8_t registerSelection, uint8_t address, uint8_t data)
+{
+  if (registerSelection == RS_Control && address < cControlRegisterShadowSize) {
+    _controlRegisterShadow[address] = data;
+  }
 }
 
 
 void AS1130::writeToMemory(uint8_t registerSelection, uint8_t address, uint8_t data)
 {
-  writeToChip(cRegisterSelectionAddress, registerSelection);
-  writeToChip(address, data);
+  writeMemoryBlock(registerSelection, address, &data, 1);
 }
 
 
-uint8_t AS1130::readFromMemory(uint8_t registerSelection, uint8_t address)
+void AS1130::writeMemoryBlock(uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint16_t length)
+{
+  bool success;
+  if (_memoryCache != nullptr && _memoryCache->isCached(registerSelection)) {
+    success = writeChangedMemory(registerSelection, startAddress, data, length, false);
+  } else {
+    success = writeMemoryMessages(registerSelection, startAddress, data, length, false);
+  }
+  // The shadow copy only follows writes which reached the chip.
+  if (success) {
+    for (uint16_t i = 0; i < length; ++i) {
+      updateControlRegisterShadow(registerSelection, startAddress + i, data[i]);
+    }
+  }
+}
+
+
+void AS1130::fillMemoryBlock(uint8_t registerSelection, uint8_t startAddress, uint8_t value, uint16_t length)
 {
-  writeToChip(cRegisterSelectionAddress, registerSelection);
-  Wire.beginTransmission(_chipAddress);
-  Wire.write(address);
-  Wire.endTransmission();
-  Wire.requestFrom(_chipAddress, 1);
-  if (Wire.available() == 1) {
-    const uint8_t data = Wire.read();
-    return data;
+  uint8_t fillData[cFillBufferSize];
+  std::memset(fillData, value, cFillBufferSize);
+  bool success;
+  if (_memoryCache != nullptr && _memoryCache->isCached(registerSelection)) {
+    success = writeChangedMemory(registerSelection, startAddress, fillData, length, true);
   } else {
-    return 0x00;
+    success = writeMemoryMessages(registerSelection, startAddress, fillData, length, true);
+  }
+  if (success) {
+    for (uint16_t i = 0; i < length; ++i) {
+      updateControlRegisterShadow(registerSelection, startAddress + i, value);
+    }
+  }
+}
+
+
+bool AS1130::writeChangedMemory(uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint16_t length, bool repeatData)
+{
+  uint16_t maximumLength = _bus->getMaximumDataLength();
+  if (repeatData && maximumLength > cFillBufferSize) {
+    maximumLength = cFillBufferSize;
+  }
+  AS1130Bus::Message messages[cMaximumMessageCount];
+  uint8_t count = 0;
+  uint16_t index = 0;
+  while (index < length) {
+    // Skip all unchanged bytes.
+    while (index < length && _memoryCache->isEqual(registerSelection, startAddress + index, data[repeatData ? 0 : index])) {
+      ++index;
+    }
+    if (index == length) {
+      break;
+    }
+    // Collect changed bytes, including small gaps of unchanged bytes.
+    const uint16_t runStart = index;
+    uint16_t runEnd = index + 1;
+    for (uint16_t next = runEnd; next < length && next - runStart < maximumLength && next - runEnd < cMaximumMergeGap + 1; ++next) {
+      if (!_memoryCache->isEqual(registerSelection, startAddress + next, data[repeatData ? 0 : next])) {
+        runEnd = next + 1;
+      }
+    }
+    if (count == 0) {
+      count = prepareRegisterSelection(messages, &registerSelection);
+    }
+    messages[count++] = AS1130Bus::Message::write(startAddress + runStart, data + (repeatData ? 0 : runStart), runEnd - runStart);
+    index = runEnd;
+    if (count == cMaximumMessageCount) {
+      if (!transfer(messages, count)) {
+        _memoryCache->invalidate(registerSelection);
+        return false;
+      }
+      count = 0;
+    }
+  }
+  if (count > 0 && !transfer(messages, count)) {
+    _memoryCache->invalidate(registerSelection);
+    return false;
+  }
+  for (uint16_t i = 0; i < length; ++i) {
+    _memoryCache->update(registerSelection, startAddress + i, data[repeatData ? 0 : i]);
   }
+  return true;
+}
+
+
+void AS1130::writePwmColumns(uint8_t setIndex, const uint8_t *columnOffsets, uint8_t x, uint8_t y, uint8_t columnCount, uint8_t rowCount, uint8_t stride, const uint8_t *values)
+{
+  uint8_t columnValues[11];
+  for (uint8_t column = 0; column < columnCount; ++column) {
+    for (uint8_t row = 0; row < rowCount; ++row) {
+      columnValues[row] = values[row*stride+column];
+    }
+    const uint8_t address = cFrameSize + columnOffsets[x+column] + y;
+    writeMemoryBlock(RS_BlinkAndPwmSet + setIndex, address, columnValues, rowCount);
+  }
+}
+
+
+uint8_t AS1130::readFromMemory(uint8_t registerSelection, uint8_t address)
+{
+  uint8_t data;
+  readMemoryBlock(registerSelection, address, &data, 1);
+  return data;
+}
+
+
+void AS1130::readMemoryBlock(uint8_t registerSelection, uint8_t startAddress, uint8_t *data, uint16_t length)
+{
+  uint8_t * const blockData = data;
+  const uint16_t blockLength = length;
+  const uint16_t maximumLength = _bus->getMaximumDataLength();
+  AS1130Bus::Message messages[cMaximumMessageCount];
+  uint8_t count = prepareRegisterSelection(messages, &registerSelection);
+  while (length > 0) {
+    const uint16_t messageLength = (length > maximumLength ? maximumLength : length);
+    messages[count++] = AS1130Bus::Message::write(startAddress, nullptr, 0);
+    messages[count++] = AS1130Bus::Message::read(data, messageLength);
+    startAddress += messageLength;
+    data += messageLength;
+    length -= messageLength;
+    if (count + 2 > cMaximumMessageCount || length == 0) {
+      if (!transfer(messages, count)) {
+        std::memset(blockData, 0, blockLength);
+        return;
+      }
+      count = 0;
+    }
+  }
+}
+
+
+void AS1130::setMemoryCache(AS1130MemoryCache *memoryCache)
+{
+  _memoryCache = memoryCache;
 }
 
 
@@ -465,7 +991,15 @@ uint8_t AS1130::readControlRegister(ControlRegister controlRegister)
 
 void AS1130::writeControlRegisterBits(ControlRegister controlRegister, uint8_t mask, uint8_t data)
 {
-  uint8_t registerData = readControlRegister(controlRegister);
+  uint8_t registerData;
+  if (_isControlRegisterShadowEnabled && controlRegister < cControlRegisterShadowSize) {
+    registerData = _controlRegisterShadow[controlRegister];
+  } else {
+#if defined(LRAS1130_STATISTICS)
+    ++_statistics.readModifyWriteReads;
+#endif
+    registerData = readControlRegister(controlRegister);
+  }
   registerData &= (~mask);
   registerData |= (data & mask);
   writeControlRegister(controlRegister, registerData);
@@ -494,6 +1028,38 @@ void AS1130::setOrClearControlRegisterBits(ControlRegister controlRegister, uint
 }
 
 
+const AS1130::Statistics& AS1130::getStatistics() const
+{
+  return _statistics;
 }
 
 
+void AS1130::resetStatistics()
+{
+  std::memset(&_statistics, 0, sizeof(Statistics));
+}
+
+
+void AS1130::updateStatistics(const AS1130Bus::Message *messages, uint8_t count, bool success, uint32_t durationUs)
+{
+  ++_statistics.transfers;
+  _statistics.transactions += count;
+  _statistics.busTimeUs += durationUs;
+  if (!success) {
+    ++_statistics.failedTransfers;
+  }
+  for (uint8_t i = 0; i < count; ++i) {
+    const AS1130Bus::Message &message = messages[i];
+    if (message.isRead) {
+      _statistics.bytesRead += message.length;
+    } else {
+      _statistics.bytesWritten += message.length + 1;
+      if (message.registerAddress == cRegisterSelectionAddress && message.length > 0) {
+        ++_statistics.registerSelections;
+      }
+    }
+  }
+}
+
+
+}
@@ -19,7 +19,13 @@
 #pragma once
 
 
-#include <Wire.h>
+#include "LRAS1130Bus.h"
+#include "LRAS1130Frame.h"
+#include "LRAS1130MemoryCache.h"
+
+#if defined(ARDUINO)
+#include "LRAS1130WireBus.h"
+#endif
 
 #include <cinttypes>
 
@@ -189,6 +195,39 @@ public:
     LedStatusDisabled ///< The LED is disabled in the driver.
   };
 
+  /// @brief The status of all LEDs, read with readLedStatusMap().
+  ///
+  struct LedStatusMap {
+    /// @brief Get the status of a LED.
+    ///
+    /// @param ledIndex The index of the LED in the chip numbering, see getLedStatus().
+    /// @return The status for the given LED index.
+    ///
+    LedStatus getLedStatus(uint8_t ledIndex) const;
+
+    /// @brief Get the status of a LED in a 24x5 matrix.
+    ///
+    /// @param x The column, between 0 and 23.
+    /// @param y The row, between 0 and 4.
+    /// @return The status for the LED at the given position.
+    ///
+    LedStatus getLedStatus24x5(uint8_t x, uint8_t y) const;
+
+    /// @brief Get the status of a LED in a 12x11 matrix.
+    ///
+    /// @param x The column, between 0 and 11.
+    /// @param y The row, between 0 and 10.
+    /// @return The status for the LED at the given position.
+    ///
+    LedStatus getLedStatus12x11(uint8_t x, uint8_t y) const;
+
+    /// @brief Get the number of open LEDs.
+    ///
+    uint8_t getOpenLedCount() const;
+
+    uint8_t data[0x18]; ///< The content of the open LED registers. A set bit marks a working LED.
+  };
+
 public:
   /// @name Low-Level Definitions.
   /// Definitions used for low-level operations.
@@ -298,17 +337,31 @@ public:
   /// @}
 
 public:
+#if defined(ARDUINO)
   /// @brief Create a new driver instance
   ///
+  /// The driver uses the global `Wire` object for the communication.
+  ///
   /// @param chipAddress The address of the chip.
   ///
   AS1130(ChipAddress chipAddress = ChipAddress0);
+#endif
+
+  /// @brief Create a new driver instance using the given bus.
+  ///
+  /// @param bus The bus used for the communication. The bus object has to
+  ///   exist as long as this driver instance.
+  /// @param chipAddress The address of the chip.
+  ///
+  AS1130(AS1130Bus &bus, ChipAddress chipAddress = ChipAddress0);
 
 public: // High-level functions.
   /// @brief Check the chip communication.
   ///
   /// This function checks if the chip aknowledges a command on the I2C bus.
   /// If it does, this function returns `true`, otherwise it returns `false`.
+  /// The check uses AS1130Bus::probe(), which is sent right away even on a
+  /// queuing bus like AS1130AsyncBus, and does not change the register selection.
   ///
   /// @return `true` if the chip answers, `false` if there is no answer.
   /// 
@@ -360,6 +413,49 @@ public: // High-level functions.
   ///
   void setOnOffFrame24x5(uint8_t frameIndex, const uint8_t *data, uint8_t pwmSetIndex = 0);
 
+  /// @brief Set-up a on/off frame with data for a 12x11 matrix.
+  ///
+  /// This function is written for a 12x11 LED matrix, where each column is one
+  /// segment of the chip. You have to specify 22 bytes of data, two bytes for
+  /// each row. The bits are specified horizontally as shown in the example below,
+  /// the last four bits of each row are ignored.
+  ///
+  /// Example array definition:
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// const uint8_t exampleFrame[] = {
+  ///   0b11111111, 0b11110000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b10000000, 0b00010000,
+  ///   0b11111111, 0b11110000};
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  ///
+  /// @param frameIndex The index of the frame. This has to be a value between 0 and 35. Depending 
+  ///   on your RAM configuration this can be less. The frame number is not checked to be
+  ///   valid. See the RAM configuration for details.
+  /// @param pwmSetIndex The PWM set index for this frame. It has to a value between 0 and 7
+  ///   selecting one of the PWM sets.
+  /// @param data An array with 22 bytes. Each set bit will enable the corresponding LED.
+  ///
+  void setOnOffFrame12x11(uint8_t frameIndex, const uint8_t *data, uint8_t pwmSetIndex = 0);
+
+  /// @brief Set-up a on/off frame with already converted data.
+  ///
+  /// The frame data is written to the chip without any conversion or copy.
+  /// Use this function with frames created at compile time using AS1130Frame::from24x5()
+  /// or AS1130Frame::from12x11().
+  ///
+  /// @param frameIndex The index of the frame. This has to be a value between 0 and 35.
+  /// @param frame The frame data, including the PWM set index.
+  ///
+  void setOnOffFrame(uint8_t frameIndex, const AS1130Frame &frame);
+
   /// @brief Set-up a on/off frame with all LEDs enabled.
   ///
   /// @param frameIndex The index of the frame. This has to be a value between 0 and 35.
@@ -368,6 +464,26 @@ public: // High-level functions.
   ///
   void setOnOffFrameAllOn(uint8_t frameIndex, uint8_t pwmSetIndex = 0);
 
+  /// @brief Convert a 24x5 bitmap into the on/off frame data of the chip.
+  ///
+  /// This is the conversion used by setOnOffFrame24x5(). It does not access the chip.
+  ///
+  /// @param data An array with 15 bytes, in the format described for setOnOffFrame24x5().
+  /// @param frameData An array for the 24 bytes of the on/off frame.
+  /// @param pwmSetIndex The PWM set index for this frame.
+  ///
+  static void encodeFrame24x5(const uint8_t *data, uint8_t *frameData, uint8_t pwmSetIndex = 0);
+
+  /// @brief Convert a 12x11 bitmap into the on/off frame data of the chip.
+  ///
+  /// This is the conversion used by setOnOffFrame12x11(). It does not access the chip.
+  ///
+  /// @param data An array with 22 bytes, in the format described for setOnOffFrame12x11().
+  /// @param frameData An array for the 24 bytes of the on/off frame.
+  /// @param pwmSetIndex The PWM set index for this frame.
+  ///
+  static void encodeFrame12x11(const uint8_t *data, uint8_t *frameData, uint8_t pwmSetIndex = 0);
+
   /// @brief Set-up a blink&PWM set with values for all LEDs.
   ///
   /// This will set the given blink&PWM set and set all LEDs to the given values.
@@ -378,6 +494,98 @@ public: // High-level functions.
   ///
   void setBlinkAndPwmSetAll(uint8_t setIndex, bool doesBlink = false, uint8_t pwmValue = 0xff);
 
+  /// @brief Set the blink bits of a blink&PWM set for a 24x5 matrix.
+  ///
+  /// Only the 24 blink bytes of the set are written, with one burst. The PWM values
+  /// are not changed.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param data An array with 15 bytes, in the format described for setOnOffFrame24x5().
+  ///   Each set bit will let the corresponding LED blink.
+  ///
+  void setBlinkMask24x5(uint8_t setIndex, const uint8_t *data);
+
+  /// @brief Set the blink bits of a blink&PWM set for a 12x11 matrix.
+  ///
+  /// Only the 24 blink bytes of the set are written, with one burst. The PWM values
+  /// are not changed.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param data An array with 22 bytes, in the format described for setOnOffFrame12x11().
+  ///   Each set bit will let the corresponding LED blink.
+  ///
+  void setBlinkMask12x11(uint8_t setIndex, const uint8_t *data);
+
+  /// @brief Set the blink bits of a blink&PWM set with already converted data.
+  ///
+  /// The blink bits use the same layout as an on/off frame. Create the frame
+  /// with a PWM set index of zero.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param frame The blink bits in the layout of an on/off frame.
+  ///
+  void setBlinkMask(uint8_t setIndex, const AS1130Frame &frame);
+
+  /// @brief Set the PWM values of a blink&PWM set for all LEDs.
+  ///
+  /// The values are written with one burst, the blink bits of the set are not changed.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param values An array with 132 PWM values in the order of the chip. This
+  ///   are 11 values for each of the 12 segments.
+  ///
+  void setPwmValues(uint8_t setIndex, const uint8_t *values);
+
+  /// @brief Set the PWM values of a blink&PWM set for a 24x5 matrix.
+  ///
+  /// The values are converted into the order of the chip and written with one burst.
+  /// The blink bits of the set are not changed.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param values An array with 120 PWM values, row by row. The value for
+  ///   the LED at x/y is at index `y*24+x`.
+  ///
+  void setPwmValues24x5(uint8_t setIndex, const uint8_t *values);
+
+  /// @brief Set the PWM values of a blink&PWM set for a 12x11 matrix.
+  ///
+  /// The values are converted into the order of the chip and written with one burst.
+  /// The blink bits of the set are not changed.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param values An array with 132 PWM values, row by row. The value for
+  ///   the LED at x/y is at index `y*12+x`.
+  ///
+  void setPwmValues12x11(uint8_t setIndex, const uint8_t *values);
+
+  /// @brief Set the PWM values for a rectangular region of a 24x5 matrix.
+  ///
+  /// Only the values in the region are written. Each column of the region is
+  /// written with one burst. Parts of the region outside of the matrix are ignored.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param x The first column of the region.
+  /// @param y The first row of the region.
+  /// @param width The number of columns of the region.
+  /// @param height The number of rows of the region.
+  /// @param values An array with `width*height` PWM values, row by row.
+  ///
+  void setPwmValuesRect24x5(uint8_t setIndex, uint8_t x, uint8_t y, uint8_t width, uint8_t height, const uint8_t *values);
+
+  /// @brief Set the PWM values for a rectangular region of a 12x11 matrix.
+  ///
+  /// Only the values in the region are written. Each column of the region is
+  /// written with one burst. Parts of the region outside of the matrix are ignored.
+  ///
+  /// @param setIndex The set index has to be a value between 0 and 5.
+  /// @param x The first column of the region.
+  /// @param y The first row of the region.
+  /// @param width The number of columns of the region.
+  /// @param height The number of rows of the region.
+  /// @param values An array with `width*height` PWM values, row by row.
+  ///
+  void setPwmValuesRect12x11(uint8_t setIndex, uint8_t x, uint8_t y, uint8_t width, uint8_t height, const uint8_t *values);
+
   /// @brief Set the dot correction data.
   ///
   /// This correction data is a correction factor for all 12 segments of the display.
@@ -573,7 +781,8 @@ public: // High-level functions.
 
   /// @brief Reset the chip.
   ///
-  /// This will reset the chip using the initialize flag.
+  /// This will reset the chip using the initialize flag. The chip is in shutdown
+  /// mode after the reset.
   ///
   void resetChip();
 
@@ -602,6 +811,40 @@ public: // High-level functions.
   ///
   LedStatus getLedStatus(uint8_t ledIndex);
 
+  /// @brief Read the status of all LEDs.
+  ///
+  /// This reads all open LED registers with one burst read. Like for getLedStatus(),
+  /// you have to run a test before the map contains valid values.
+  ///
+  /// @param ledStatusMap The map to fill with the LED status.
+  ///
+  void readLedStatusMap(LedStatusMap &ledStatusMap);
+
+  /// @brief Get the LED index for a position in a 24x5 matrix.
+  ///
+  /// @param x The column, between 0 and 23.
+  /// @param y The row, between 0 and 4.
+  /// @return The index of the LED in the chip numbering.
+  ///
+  static uint8_t getLedIndex24x5(uint8_t x, uint8_t y);
+
+  /// @brief Get the LED index for a position in a 12x11 matrix.
+  ///
+  /// Each column of the matrix is one segment of the chip.
+  ///
+  /// @param x The column, between 0 and 11.
+  /// @param y The row, between 0 and 10.
+  /// @return The index of the LED in the chip numbering.
+  ///
+  static uint8_t getLedIndex12x11(uint8_t x, uint8_t y);
+
+  /// @brief Get the address of the PWM value for a LED in a blink&PWM set.
+  ///
+  /// @param ledIndex The index of the LED in the chip numbering.
+  /// @return The address of the PWM value, between 0x18 and 0x9b.
+  ///
+  static uint8_t getPwmAddress(uint8_t ledIndex);
+
   /// @brief Check if a LED test is running.
   ///
   /// @return `true` if a LED test is running, `false` if no test is running.
@@ -622,6 +865,11 @@ public: // High-level functions.
 
   /// @brief Get the interrupt status register.
   ///
+  /// The register selection is always written before the status is read,
+  /// because a power on reset sets it back to RS_NOP without the driver
+  /// noticing. If the status reports a power on reset (IMF_POR), all cached
+  /// state is invalidated using invalidateCachedState().
+  ///
   /// @return The bitmask with the interrupt status.
   ///
   uint8_t getInterruptStatus();
@@ -638,6 +886,41 @@ public:
   ///
   void writeToChip(uint8_t address, uint8_t data);
 
+  /// @brief Select a register bank.
+  ///
+  /// The last selected register bank is cached. The register selection is only
+  /// written to the chip if it differs from the cached one.
+  ///
+  /// @param registerSelection The register selection address.
+  ///
+  void selectRegister(uint8_t registerSelection);
+
+  /// @brief Invalidate the cached register selection.
+  ///
+  /// The next memory access will write the register selection to the chip.
+  /// This is done automatically after resetChip() and after a failed transmission.
+  /// Call this function if the chip was reset by other means.
+  ///
+  void invalidateRegisterSelection();
+
+  /// @brief Invalidate all state the driver keeps about the chip.
+  ///
+  /// This invalidates the cached register selection and the memory cache, and
+  /// reads the shadow copy of the control registers from the chip again if it
+  /// is enabled. This is done automatically after resetChip() and after a power
+  /// on reset is reported by getInterruptStatus(). Call this function if writes
+  /// may have failed without the driver noticing, e.g. with AS1130AsyncBus.
+  ///
+  void invalidateCachedState();
+
+  /// @brief Get the bus used for the communication.
+  ///
+  AS1130Bus& getBus() const;
+
+  /// @brief Get the address of the chip.
+  ///
+  ChipAddress getChipAddress() const;
+
   /// @brief Write a byte to a given memory location.
   ///
   /// @param registerSelection The register selection address.
@@ -646,6 +929,30 @@ public:
   ///
   void writeToMemory(uint8_t registerSelection, uint8_t address, uint8_t data);
 
+  /// @brief Write a block of bytes to consecutive memory locations.
+  ///
+  /// The register selection is written once, then the data is streamed to the
+  /// chip using its address auto-increment. Large blocks are split into multiple
+  /// messages to fit into the buffer of the bus.
+  ///
+  /// @param registerSelection The register selection address.
+  /// @param startAddress The address of the first register.
+  /// @param data Pointer to the bytes to write.
+  /// @param length The number of bytes to write.
+  ///
+  void writeMemoryBlock(uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint16_t length);
+
+  /// @brief Fill consecutive memory locations with the same byte.
+  ///
+  /// Works like writeMemoryBlock(), but writes the same value to all locations.
+  ///
+  /// @param registerSelection The register selection address.
+  /// @param startAddress The address of the first register.
+  /// @param value The byte to write to all locations.
+  /// @param length The number of bytes to write.
+  ///
+  void fillMemoryBlock(uint8_t registerSelection, uint8_t startAddress, uint8_t value, uint16_t length);
+
   /// @brief Read a byte from a given memory location.
   ///
   /// @param registerSelection The register selection address.
@@ -654,6 +961,52 @@ public:
   ///
   uint8_t readFromMemory(uint8_t registerSelection, uint8_t address);  
 
+  /// @brief Read a block of bytes from consecutive memory locations.
+  ///
+  /// The register selection is written once, then the data is read using the
+  /// address auto-increment of the chip. If the transmission fails, the
+  /// whole block is set to zero.
+  ///
+  /// @param registerSelection The register selection address.
+  /// @param startAddress The address of the first register.
+  /// @param data Pointer to a buffer for the read bytes.
+  /// @param length The number of bytes to read.
+  ///
+  void readMemoryBlock(uint8_t registerSelection, uint8_t startAddress, uint8_t *data, uint16_t length);
+
+  /// @brief Enable or disable the shadow copy of the control registers.
+  ///
+  /// If enabled, the driver keeps a copy of the writable control registers
+  /// (CR_Picture to CR_ClockSynchronization). All functions which change
+  /// bits in these registers use the copy instead of reading the register
+  /// from the chip first. Enabling the shadow copy calls syncShadowFromChip().
+  ///
+  /// The shadow copy assumes that no other device changes the control registers.
+  /// A failed write leaves the shadow copy unchanged. Call syncShadowFromChip()
+  /// when the communication works again.
+  ///
+  /// @param enabled True to enable the shadow copy, false to disable it.
+  ///
+  void setControlRegisterShadowEnabled(bool enabled);
+
+  /// @brief Read all writable control registers into the shadow copy.
+  ///
+  /// This reads the registers from the chip with one burst read.
+  ///
+  void syncShadowFromChip();
+
+  /// @brief Set a cache for the on/off frames and blink&PWM sets.
+  ///
+  /// If a cache is set, all writes to on/off frames and blink&PWM sets are compared
+  /// with the cached content. Only the changed bytes are sent to the chip. Runs of
+  /// changed bytes separated by small gaps are merged into one burst. The cache is
+  /// invalidated after resetChip(), a detected power on reset or a failed transfer.
+  ///
+  /// @param memoryCache The cache to use, or `nullptr` to disable the cache. The
+  ///   cache has to exist as long as it is set.
+  ///
+  void setMemoryCache(AS1130MemoryCache *memoryCache);
+
   /// @brief Write a byte to a control register.
   ///
   /// @param controlRegister The control register.
@@ -700,8 +1053,93 @@ public:
 
   /// @}
 
+public:
+  /// @name Statistics.
+  /// Counters for the bus traffic of this driver instance. The counters are
+  /// only updated if the library is compiled with `LRAS1130_STATISTICS` defined,
+  /// otherwise they stay zero. The functions and the size of the driver do not
+  /// depend on the define, so a sketch and the library always agree on the layout.
+  /// @{
+
+  /// @brief The bus traffic statistics.
+  ///
+  struct Statistics {
+    uint32_t transfers; ///< The number of transfers passed to the bus.
+    uint32_t transactions; ///< The number of I2C messages in all transfers.
+    uint32_t bytesWritten; ///< The number of written bytes, including the register addresses.
+    uint32_t bytesRead; ///< The number of read bytes.
+    uint32_t registerSelections; ///< The number of register selection writes.
+    uint32_t readModifyWriteReads; ///< The number of register reads to change bits.
+    uint32_t failedTransfers; ///< The number of transfers which were not acknowledged.
+    uint32_t busTimeUs; ///< The cumulative time spent in transfers, in microseconds.
+  };
+
+  /// @brief Get the statistics since the last reset.
+  ///
+  const Statistics& getStatistics() const;
+
+  /// @brief Reset all statistics counters to zero.
+  ///
+  void resetStatistics();
+
+  /// @}
+
+private:
+  /// @brief Update the shadow copy after a successful write to the given memory location.
+  ///
+  void updateControlRegisterShadow(uint8_t registerSelection, uint8_t address, uint8_t data);
+
+  /// @brief Pass messages to the bus and track the register selection.
+  ///
+  /// @return `true` on success, `false` if the transfer failed.
+  ///
+  bool transfer(const AS1130Bus::Message *messages, uint8_t count);
+
+  /// @brief Prepare a register selection message if the selection has to change.
+  ///
+  /// @return The number of prepared messages, 0 or 1.
+  ///
+  uint8_t prepareRegisterSelection(AS1130Bus::Message *message, const uint8_t *registerSelection);
+
+  /// @brief Update the statistics after a transfer.
+  ///
+  void updateStatistics(const AS1130Bus::Message *messages, uint8_t count, bool success, uint32_t durationUs);
+
+  /// @brief Write a block of memory as one or more transfers.
+  ///
+  /// If `repeatData` is true, the same data is sent for each message.
+  ///
+  /// @return `true` on success, `false` if a transfer failed.
+  ///
+  bool writeMemoryMessages(uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint16_t length, bool repeatData);
+
+  /// @brief Write only the bytes which differ from the memory cache.
+  ///
+  /// If `repeatData` is true, `data` points to a fill buffer of `cFillBufferSize`
+  /// bytes, all with the same value. Only `data[0]` is compared with the cache,
+  /// and each message is limited to the size of the fill buffer.
+  /// The cache is only updated if all transfers succeed, otherwise the cached
+  /// content of the register selection is invalidated.
+  ///
+  /// @return `true` on success, `false` if a transfer failed.
+  ///
+  bool writeChangedMemory(uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint16_t length, bool repeatData);
+
+  /// @brief Write the PWM values for a rectangular region, one column at a time.
+  ///
+  /// @param columnOffsets The offset of the first PWM value for each column of the matrix.
+  /// @param stride The number of values in one row of the `values` array.
+  ///
+  void writePwmColumns(uint8_t setIndex, const uint8_t *columnOffsets, uint8_t x, uint8_t y, uint8_t columnCount, uint8_t rowCount, uint8_t stride, const uint8_t *values);
+
 private:
+  AS1130Bus *_bus; ///< The bus used for the communication.
   uint8_t _chipAddress; ///< The selected address of the chip.
+  uint8_t _registerSelection; ///< The last register selection written to the chip.
+  bool _isControlRegisterShadowEnabled; ///< If the shadow copy of the control registers is used.
+  AS1130MemoryCache *_memoryCache; ///< The optional cache for frames and sets.
+  uint8_t _controlRegisterShadow[CR_ClockSynchronization+1]; ///< The shadow copy of the control registers.
+  Statistics _statistics; ///< The bus traffic statistics.
 };
 
 }
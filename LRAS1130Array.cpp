@@ -0,0 +1,327 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130Array.h"
+
+
+#include <cstring>
+
+
+namespace lr {
+
+
+namespace {
+const uint8_t cBitmapSize = 22; ///< The size of the largest bitmap for a tile.
+}
+
+
+AS1130Array::AS1130Array(uint8_t *frameBuffer, uint16_t width, uint16_t height)
+  : _frameBuffer(frameBuffer), _width(width), _height(height), _chipCount(0), _frameIndex(0),
+    _pwmSetIndex(0), _changedChips(0), _previousChangedChips(0), _hiddenFrameIndex(1), _lastSkew(0)
+{
+}
+
+
+bool AS1130Array::addChip(AS1130 &driver, uint16_t x, uint16_t y, TileLayout layout, Orientation orientation)
+{
+  if (_chipCount >= cMaximumChipCount) {
+    return false;
+  }
+  Tile &tile = _tiles[_chipCount];
+  tile.driver = &driver;
+  tile.x = x;
+  tile.y = y;
+  tile.layout = layout;
+  tile.orientation = orientation;
+  _changedChips |= (1u << _chipCount);
+  ++_chipCount;
+  return true;
+}
+
+
+uint8_t AS1130Array::getChipCount() const
+{
+  return _chipCount;
+}
+
+
+AS1130& AS1130Array::getChip(uint8_t chipIndex) const
+{
+  return *_tiles[chipIndex].driver;
+}
+
+
+void AS1130Array::invalidateRegisterSelection()
+{
+  for (uint8_t chipIndex = 0; chipIndex < _chipCount; ++chipIndex) {
+    _tiles[chipIndex].driver->invalidateRegisterSelection();
+  }
+}
+
+
+void AS1130Array::setFrameIndex(uint8_t frameIndex, uint8_t pwmSetIndex)
+{
+  if (frameIndex != _frameIndex || pwmSetIndex != _pwmSetIndex) {
+    _frameIndex = frameIndex;
+    _pwmSetIndex = pwmSetIndex;
+    markAllChanged();
+  }
+}
+
+
+uint16_t AS1130Array::getWidth() const
+{
+  return _width;
+}
+
+
+uint16_t AS1130Array::getHeight() const
+{
+  return _height;
+}
+
+
+void AS1130Array::setPixel(uint16_t x, uint16_t y, bool enabled)
+{
+  if (x >= _width || y >= _height) {
+    return;
+  }
+  uint8_t &data = _frameBuffer[static_cast<uint32_t>(y) * ((_width + 7) / 8) + (x / 8)];
+  const uint8_t mask = (0x80 >> (x & 0x07));
+  if (((data & mask) != 0) != enabled) {
+    data ^= mask;
+    _changedChips |= getChipMask(x, y, 1, 1);
+  }
+}
+
+
+bool AS1130Array::getPixel(uint16_t x, uint16_t y) const
+{
+  if (x >= _width || y >= _height) {
+    return false;
+  }
+  return (_frameBuffer[static_cast<uint32_t>(y) * ((_width + 7) / 8) + (x / 8)] & (0x80 >> (x & 0x07))) != 0;
+}
+
+
+void AS1130Array::fill(bool enabled)
+{
+  std::memset(_frameBuffer, enabled ? 0xff : 0x00, static_cast<size_t>((_width + 7) / 8) * _height);
+  markAllChanged();
+}
+
+
+void AS1130Array::markChanged(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+  _changedChips |= getChipMask(x, y, width, height);
+}
+
+
+void AS1130Array::markAllChanged()
+{
+  _changedChips = static_cast<uint16_t>((1ul << _chipCount) - 1);
+}
+
+
+bool AS1130Array::isChanged() const
+{
+  return _changedChips != 0;
+}
+
+
+void AS1130Array::update()
+{
+  uploadTiles(_changedChips, _frameIndex);
+  _changedChips = 0;
+}
+
+
+void AS1130Array::setClockSynchronization(uint8_t masterChipIndex, AS1130::ClockFrequency clockFrequency)
+{
+  // Configure the slaves first, so they follow the master as soon as it sends the clock.
+  for (uint8_t chipIndex = 0; chipIndex < _chipCount; ++chipIndex) {
+    if (chipIndex != masterChipIndex) {
+      _tiles[chipIndex].driver->setClockSynchronization(AS1130::SynchronizationIn, clockFrequency);
+    }
+  }
+  if (masterChipIndex < _chipCount) {
+    _tiles[masterChipIndex].driver->setClockSynchronization(AS1130::SynchronizationOut, clockFrequency);
+  }
+}
+
+
+void AS1130Array::setBufferFrames(uint8_t firstFrameIndex, uint8_t secondFrameIndex)
+{
+  _frameIndex = firstFrameIndex;
+  _hiddenFrameIndex = secondFrameIndex;
+  _previousChangedChips = 0;
+  markAllChanged();
+}
+
+
+uint32_t AS1130Array::flip(bool blinkAll)
+{
+  // The hidden frame misses the changes of the last flip and the current ones.
+  const uint16_t changedChips = _changedChips;
+  uploadTiles(changedChips | _previousChangedChips, _hiddenFrameIndex);
+  _previousChangedChips = changedChips;
+  _changedChips = 0;
+  const uint8_t displayedFrameIndex = _hiddenFrameIndex;
+  _hiddenFrameIndex = _frameIndex;
+  _frameIndex = displayedFrameIndex;
+  return startPicture(displayedFrameIndex, blinkAll);
+}
+
+
+uint32_t AS1130Array::startPicture(uint8_t frameIndex, bool blinkAll)
+{
+  uint8_t data = AS1130::PF_DisplayPicture | (frameIndex & AS1130::PF_PictureAddressMask);
+  if (blinkAll) {
+    data |= AS1130::PF_BlinkPicture;
+  }
+  return writeControlRegisterToAll(AS1130::CR_Picture, data);
+}
+
+
+uint32_t AS1130Array::startMovie(uint8_t firstFrameIndex, bool blinkAll)
+{
+  uint8_t data = AS1130::MF_DisplayMovie | (firstFrameIndex & AS1130::MF_MovieAddressMask);
+  if (blinkAll) {
+    data |= AS1130::MF_BlinkMovie;
+  }
+  return writeControlRegisterToAll(AS1130::CR_Movie, data);
+}
+
+
+uint32_t AS1130Array::getLastSkew() const
+{
+  return _lastSkew;
+}
+
+
+void AS1130Array::getTileFrame(uint8_t chipIndex, AS1130Frame &frame) const
+{
+  const Tile &tile = _tiles[chipIndex];
+  const uint8_t tileWidth = (tile.layout == Tile24x5 ? 24 : 12);
+  const uint8_t tileHeight = (tile.layout == Tile24x5 ? 5 : 11);
+  const uint8_t bytesPerRow = (tileWidth + 7) / 8;
+  uint8_t bitmap[cBitmapSize];
+  std::memset(bitmap, 0, sizeof(bitmap));
+  for (uint8_t ty = 0; ty < tileHeight; ++ty) {
+    for (uint8_t tx = 0; tx < tileWidth; ++tx) {
+      uint16_t x;
+      uint16_t y;
+      switch (tile.orientation) {
+      case Rotation90:
+        x = tile.x + (tileHeight - 1 - ty);
+        y = tile.y + tx;
+        break;
+      case Rotation180:
+        x = tile.x + (tileWidth - 1 - tx);
+        y = tile.y + (tileHeight - 1 - ty);
+        break;
+      case Rotation270:
+        x = tile.x + ty;
+        y = tile.y + (tileWidth - 1 - tx);
+        break;
+      default:
+        x = tile.x + tx;
+        y = tile.y + ty;
+        break;
+      }
+      if (getPixel(x, y)) {
+        bitmap[ty * bytesPerRow + (tx / 8)] |= (0x80 >> (tx & 0x07));
+      }
+    }
+  }
+  if (tile.layout == Tile24x5) {
+    AS1130::encodeFrame24x5(bitmap, frame.data, _pwmSetIndex);
+  } else {
+    AS1130::encodeFrame12x11(bitmap, frame.data, _pwmSetIndex);
+  }
+}
+
+
+void AS1130Array::getTileSize(const Tile &tile, uint16_t &width, uint16_t &height)
+{
+  const uint16_t tileWidth = (tile.layout == Tile24x5 ? 24 : 12);
+  const uint16_t tileHeight = (tile.layout == Tile24x5 ? 5 : 11);
+  if (tile.orientation == Rotation90 || tile.orientation == Rotation270) {
+    width = tileHeight;
+    height = tileWidth;
+  } else {
+    width = tileWidth;
+    height = tileHeight;
+  }
+}
+
+
+uint16_t AS1130Array::getChipMask(uint16_t x, uint16_t y, uint16_t width, uint16_t height) const
+{
+  uint16_t result = 0;
+  for (uint8_t chipIndex = 0; chipIndex < _chipCount; ++chipIndex) {
+    const Tile &tile = _tiles[chipIndex];
+    uint16_t tileWidth;
+    uint16_t tileHeight;
+    getTileSize(tile, tileWidth, tileHeight);
+    if (x < tile.x + tileWidth && tile.x < x + width && y < tile.y + tileHeight && tile.y < y + height) {
+      result |= (1u << chipIndex);
+    }
+  }
+  return result;
+}
+
+
+void AS1130Array::uploadTiles(uint16_t chipMask, uint8_t frameIndex)
+{
+  // Convert all tiles first, so the writes follow each other without gaps.
+  AS1130Frame frames[cMaximumChipCount];
+  for (uint8_t chipIndex = 0; chipIndex < _chipCount; ++chipIndex) {
+    if ((chipMask & (1u << chipIndex)) != 0) {
+      getTileFrame(chipIndex, frames[chipIndex]);
+    }
+  }
+  for (uint8_t chipIndex = 0; chipIndex < _chipCount; ++chipIndex) {
+    if ((chipMask & (1u << chipIndex)) != 0) {
+      _tiles[chipIndex].driver->setOnOffFrame(frameIndex, frames[chipIndex]);
+    }
+  }
+}
+
+
+uint32_t AS1130Array::writeControlRegisterToAll(AS1130::ControlRegister controlRegister, uint8_t data)
+{
+  if (_chipCount == 0) {
+    return 0;
+  }
+  // Select the control registers first, so each timed write is a single message.
+  for (uint8_t chipIndex = 0; chipIndex < _chipCount; ++chipIndex) {
+    _tiles[chipIndex].driver->selectRegister(AS1130::RS_Control);
+  }
+  AS1130Bus &bus = _tiles[0].driver->getBus();
+  _tiles[0].driver->writeControlRegister(controlRegister, data);
+  const uint32_t startTime = bus.getTimeUs();
+  for (uint8_t chipIndex = 1; chipIndex < _chipCount; ++chipIndex) {
+    _tiles[chipIndex].driver->writeControlRegister(controlRegister, data);
+  }
+  _lastSkew = bus.getTimeUs() - startTime;
+  return _lastSkew;
+}
+
+
+}
@@ -0,0 +1,275 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+
+namespace lr {
+
+
+/// @brief Multiple chips as one logical display.
+///
+/// This class maps a monochrome frame buffer onto up to 16 chips. Each chip
+/// displays one tile of the frame buffer, using a 24x5 or 12x11 matrix in one
+/// of four orientations. Changes in the frame buffer mark the affected tiles,
+/// and update() only uploads the changed tiles.
+///
+/// The frame buffer is provided by the caller. It has one bit for each pixel,
+/// row by row, and each row starts with a new byte. The first pixel of a row
+/// is the highest bit of the first byte, like the bitmaps of AS1130::setOnOffFrame24x5().
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// uint8_t frameBuffer[6*5];
+/// lr::AS1130Array display(frameBuffer, 48, 5);
+/// display.addChip(leftDriver, 0, 0, lr::AS1130Array::Tile24x5);
+/// display.addChip(rightDriver, 24, 0, lr::AS1130Array::Tile24x5);
+/// display.setPixel(30, 2, true);
+/// display.update();
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130Array
+{
+public:
+  /// @brief The maximum number of chips.
+  ///
+  static const uint8_t cMaximumChipCount = 16;
+
+  /// @brief The LED matrix of a chip.
+  ///
+  enum TileLayout : uint8_t {
+    Tile24x5, ///< A 24x5 matrix, see AS1130::setOnOffFrame24x5().
+    Tile12x11, ///< A 12x11 matrix, see AS1130::setOnOffFrame12x11().
+  };
+
+  /// @brief The orientation of a tile in the frame buffer.
+  ///
+  enum Orientation : uint8_t {
+    Rotation0, ///< The tile is not rotated.
+    Rotation90, ///< The tile is rotated 90 degrees clockwise.
+    Rotation180, ///< The tile is rotated 180 degrees.
+    Rotation270, ///< The tile is rotated 270 degrees clockwise.
+  };
+
+public:
+  /// @brief Create a new array without chips.
+  ///
+  /// @param frameBuffer The frame buffer, with `((width+7)/8)*height` bytes.
+  /// @param width The width of the frame buffer in pixels.
+  /// @param height The height of the frame buffer in pixels.
+  ///
+  AS1130Array(uint8_t *frameBuffer, uint16_t width, uint16_t height);
+
+public:
+  /// @brief Add a chip to the array.
+  ///
+  /// @param driver The driver for the chip.
+  /// @param x The left edge of the tile in the frame buffer.
+  /// @param y The top edge of the tile in the frame buffer.
+  /// @param layout The LED matrix of the chip.
+  /// @param orientation The orientation of the tile in the frame buffer.
+  /// @return `true` on success, `false` if there are already 16 chips.
+  ///
+  bool addChip(AS1130 &driver, uint16_t x, uint16_t y, TileLayout layout, Orientation orientation = Rotation0);
+
+  /// @brief Get the number of chips.
+  ///
+  uint8_t getChipCount() const;
+
+  /// @brief Get the driver for a chip.
+  ///
+  /// @param chipIndex The index of the chip, in the order the chips were added.
+  ///
+  AS1130& getChip(uint8_t chipIndex) const;
+
+  /// @brief Invalidate the cached register selection of all chips.
+  ///
+  /// Call this after other code changed the register selection of the chips,
+  /// e.g. AS1130Discovery::scan() with reading the configuration.
+  ///
+  void invalidateRegisterSelection();
+
+  /// @brief Set the frame used for the tiles on all chips.
+  ///
+  /// @param frameIndex The index of the on/off frame.
+  /// @param pwmSetIndex The PWM set index for the frame.
+  ///
+  void setFrameIndex(uint8_t frameIndex, uint8_t pwmSetIndex = 0);
+
+  /// @brief Get the width of the frame buffer.
+  ///
+  uint16_t getWidth() const;
+
+  /// @brief Get the height of the frame buffer.
+  ///
+  uint16_t getHeight() const;
+
+  /// @brief Set a pixel in the frame buffer.
+  ///
+  /// Pixels outside of the frame buffer are ignored.
+  ///
+  void setPixel(uint16_t x, uint16_t y, bool enabled);
+
+  /// @brief Get a pixel from the frame buffer.
+  ///
+  /// @return The pixel state, `false` for pixels outside of the frame buffer.
+  ///
+  bool getPixel(uint16_t x, uint16_t y) const;
+
+  /// @brief Set all pixels in the frame buffer.
+  ///
+  void fill(bool enabled);
+
+  /// @brief Mark all tiles which overlap a rectangle as changed.
+  ///
+  /// Call this after writing to the frame buffer directly.
+  ///
+  void markChanged(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+  /// @brief Mark all tiles as changed.
+  ///
+  void markAllChanged();
+
+  /// @brief Check if any tile was changed since the last update.
+  ///
+  bool isChanged() const;
+
+  /// @brief Upload all changed tiles.
+  ///
+  /// All changed tiles are converted first, then they are written to the
+  /// chips back-to-back, each tile with a single burst.
+  ///
+  void update();
+
+  /// @name Synchronization
+  /// Functions to display pictures and movies on all chips at the same time.
+  ///
+  /// All functions in this group write the start of the picture or movie to
+  /// all chips back-to-back, each with a single write, and measure the time
+  /// between the first and the last write. For the measurement, the bus of the
+  /// first chip is used.
+  /// @{
+
+  /// @brief Configure one chip as clock master and all others as slaves.
+  ///
+  /// The master sends its clock to the SYNC pin, all other chips use the clock
+  /// from their SYNC pin. The SYNC pins of all chips have to be connected.
+  ///
+  /// @param masterChipIndex The index of the master chip.
+  /// @param clockFrequency The clock frequency of the master.
+  ///
+  void setClockSynchronization(uint8_t masterChipIndex, AS1130::ClockFrequency clockFrequency);
+
+  /// @brief Use two frames on all chips for tear-free updates with flip().
+  ///
+  /// @param firstFrameIndex The index of the first on/off frame.
+  /// @param secondFrameIndex The index of the second on/off frame.
+  ///
+  void setBufferFrames(uint8_t firstFrameIndex, uint8_t secondFrameIndex);
+
+  /// @brief Upload the changed tiles to the hidden frame and display it on all chips.
+  ///
+  /// @param blinkAll True if all LEDs should blink.
+  /// @return The measured skew between the first and last chip in microseconds.
+  ///
+  uint32_t flip(bool blinkAll = false);
+
+  /// @brief Display a picture on all chips.
+  ///
+  /// @param frameIndex The index of the frame to display.
+  /// @param blinkAll True if all LEDs should blink.
+  /// @return The measured skew between the first and last chip in microseconds.
+  ///
+  uint32_t startPicture(uint8_t frameIndex, bool blinkAll = false);
+
+  /// @brief Start a movie on all chips.
+  ///
+  /// The movie settings have to be set on all chips before.
+  ///
+  /// @param firstFrameIndex The index of the first frame of the movie.
+  /// @param blinkAll True if all LEDs should blink.
+  /// @return The measured skew between the first and last chip in microseconds.
+  ///
+  uint32_t startMovie(uint8_t firstFrameIndex, bool blinkAll = false);
+
+  /// @brief Get the skew measured by the last synchronized start.
+  ///
+  uint32_t getLastSkew() const;
+
+  /// @}
+
+  /// @brief Convert the tile of a chip into a frame.
+  ///
+  /// @param chipIndex The index of the chip.
+  /// @param frame The frame to fill.
+  ///
+  void getTileFrame(uint8_t chipIndex, AS1130Frame &frame) const;
+
+protected:
+  /// @brief The position and orientation of a tile.
+  ///
+  struct Tile {
+    AS1130 *driver; ///< The driver for the chip.
+    uint16_t x; ///< The left edge of the tile.
+    uint16_t y; ///< The top edge of the tile.
+    TileLayout layout; ///< The LED matrix of the chip.
+    Orientation orientation; ///< The orientation of the tile.
+  };
+
+protected:
+  /// @brief Get the size of a tile in the frame buffer.
+  ///
+  static void getTileSize(const Tile &tile, uint16_t &width, uint16_t &height);
+
+  /// @brief Get a mask with the chips which overlap a rectangle.
+  ///
+  uint16_t getChipMask(uint16_t x, uint16_t y, uint16_t width, uint16_t height) const;
+
+  /// @brief Upload the changed tiles to the given frame.
+  ///
+  /// @param chipMask The chips to upload.
+  /// @param frameIndex The index of the on/off frame.
+  ///
+  void uploadTiles(uint16_t chipMask, uint8_t frameIndex);
+
+  /// @brief Write a control register of all chips back-to-back.
+  ///
+  /// @return The time between the first and the last write in microseconds.
+  ///
+  uint32_t writeControlRegisterToAll(AS1130::ControlRegister controlRegister, uint8_t data);
+
+protected:
+  uint8_t *_frameBuffer; ///< The frame buffer.
+  uint16_t _width; ///< The width of the frame buffer.
+  uint16_t _height; ///< The height of the frame buffer.
+  uint8_t _chipCount; ///< The number of chips.
+  uint8_t _frameIndex; ///< The on/off frame for the tiles.
+  uint8_t _pwmSetIndex; ///< The PWM set index for the tiles.
+  uint16_t _changedChips; ///< One bit for each chip with a changed tile.
+  uint16_t _previousChangedChips; ///< The chips changed before the last flip.
+  uint8_t _hiddenFrameIndex; ///< The hidden on/off frame for flip().
+  uint32_t _lastSkew; ///< The skew measured by the last synchronized start.
+  Tile _tiles[cMaximumChipCount]; ///< The tiles.
+};
+
+
+}
+
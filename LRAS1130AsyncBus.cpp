@@ -0,0 +1,288 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130AsyncBus.h"
+
+
+#include <cstring>
+
+
+namespace lr {
+
+
+namespace {
+const uint8_t cEntryWrap = 0x00; ///< The rest of the buffer is unused, continue at the start.
+const uint8_t cEntryTransfer = 0x01; ///< A transfer with write messages.
+const uint8_t cEntryCompletion = 0x02; ///< A completion callback.
+const uint8_t cTransferHeaderSize = 5; ///< Type, chip address, message count and entry size.
+const uint8_t cMessageHeaderSize = 3; ///< Register address and length.
+}
+
+
+AS1130AsyncBus::AS1130AsyncBus(AS1130Bus &bus, uint8_t *buffer, uint16_t bufferSize)
+  : _bus(bus), _buffer(buffer), _bufferSize(bufferSize), _head(0), _tail(0), _messageOffset(0),
+    _isSuccessful(true), _failedTransferCount(0), _hasFailed(false)
+{
+}
+
+
+void AS1130AsyncBus::addCompletion(CompletionCallback callback, void *context)
+{
+  const uint16_t size = 1 + sizeof(callback) + sizeof(context);
+  uint8_t *block = reserveWaiting(size);
+  if (block == nullptr) {
+    flush();
+    const bool success = _isSuccessful;
+    _isSuccessful = true;
+    callback(success, context);
+    return;
+  }
+  block[0] = cEntryCompletion;
+  std::memcpy(block + 1, &callback, sizeof(callback));
+  std::memcpy(block + 1 + sizeof(callback), &context, sizeof(context));
+  commit(block, size);
+}
+
+
+bool AS1130AsyncBus::service(uint8_t maximumMessageCount)
+{
+  uint8_t messageCount = 0;
+  while (!isIdle() && messageCount < maximumMessageCount) {
+    if (processEntry()) {
+      ++messageCount;
+    }
+  }
+  // Completions directly after the last transfer are reported without delay.
+  while (!isIdle() && _messageOffset == 0 && _buffer[_head] != cEntryTransfer) {
+    processEntry();
+  }
+  return !isIdle();
+}
+
+
+void AS1130AsyncBus::flush()
+{
+  while (!isIdle()) {
+    processEntry();
+  }
+}
+
+
+bool AS1130AsyncBus::isIdle() const
+{
+  return _head == _tail;
+}
+
+
+uint16_t AS1130AsyncBus::getQueuedByteCount() const
+{
+  const uint16_t head = _head;
+  const uint16_t tail = _tail;
+  return (tail >= head) ? (tail - head) : (_bufferSize - head + tail);
+}
+
+
+uint32_t AS1130AsyncBus::getFailedTransferCount() const
+{
+  return _failedTransferCount;
+}
+
+
+bool AS1130AsyncBus::checkFailure()
+{
+  const bool result = _hasFailed;
+  _hasFailed = false;
+  return result;
+}
+
+
+bool AS1130AsyncBus::transfer(uint8_t chipAddress, const Message *messages, uint8_t count)
+{
+  uint16_t size = cTransferHeaderSize;
+  bool isQueueable = (count > 0);
+  for (uint8_t i = 0; i < count && isQueueable; ++i) {
+    if (messages[i].isRead) {
+      isQueueable = false;
+    }
+    size += cMessageHeaderSize + messages[i].length;
+  }
+  uint8_t *block = (isQueueable ? reserveWaiting(size) : nullptr);
+  if (block == nullptr) {
+    // Reads need the result now, so the transfer has to wait for the queue.
+    flush();
+    const bool success = _bus.transfer(chipAddress, messages, count);
+    if (!success) {
+      ++_failedTransferCount;
+      _isSuccessful = false;
+      _hasFailed = true;
+    }
+    return success;
+  }
+  block[0] = cEntryTransfer;
+  block[1] = chipAddress;
+  block[2] = count;
+  block[3] = static_cast<uint8_t>(size);
+  block[4] = static_cast<uint8_t>(size >> 8);
+  uint8_t *data = block + cTransferHeaderSize;
+  for (uint8_t i = 0; i < count; ++i) {
+    const Message &message = messages[i];
+    data[0] = message.registerAddress;
+    data[1] = static_cast<uint8_t>(message.length);
+    data[2] = static_cast<uint8_t>(message.length >> 8);
+    if (message.length > 0) {
+      std::memcpy(data + cMessageHeaderSize, message.writeData, message.length);
+    }
+    data += cMessageHeaderSize + message.length;
+  }
+  commit(block, size);
+  return true;
+}
+
+
+uint16_t AS1130AsyncBus::getMaximumDataLength() const
+{
+  return _bus.getMaximumDataLength();
+}
+
+
+void AS1130AsyncBus::delayMs(uint16_t milliseconds)
+{
+  // The delay is meant to follow the transfers queued before.
+  flush();
+  _bus.delayMs(milliseconds);
+}
+
+
+uint32_t AS1130AsyncBus::getTimeUs()
+{
+  return _bus.getTimeUs();
+}
+
+
+bool AS1130AsyncBus::probe(uint8_t chipAddress)
+{
+  // A queued probe would always succeed, so it is sent after the queue.
+  // A missing chip is the answer of a probe, not a failed transfer.
+  flush();
+  return _bus.probe(chipAddress);
+}
+
+
+uint8_t* AS1130AsyncBus::reserve(uint16_t size)
+{
+  if (isIdle()) {
+    _head = 0;
+    _tail = 0;
+  }
+  const uint16_t head = _head;
+  const uint16_t tail = _tail;
+  if (tail >= head) {
+    // One byte stays unused, so a full buffer is not mistaken for an empty one.
+    const uint16_t spaceAtEnd = _bufferSize - tail - (head == 0 ? 1 : 0);
+    if (size <= spaceAtEnd) {
+      return _buffer + tail;
+    }
+    if (head > 0 && size <= head - 1) {
+      _buffer[tail] = cEntryWrap;
+      _tail = 0;
+      return _buffer;
+    }
+    return nullptr;
+  }
+  if (size <= head - tail - 1) {
+    return _buffer + tail;
+  }
+  return nullptr;
+}
+
+
+void AS1130AsyncBus::commit(uint8_t *block, uint16_t size)
+{
+  uint16_t tail = static_cast<uint16_t>(block - _buffer) + size;
+  if (tail == _bufferSize) {
+    tail = 0;
+  }
+  _tail = tail;
+}
+
+
+uint8_t* AS1130AsyncBus::reserveWaiting(uint16_t size)
+{
+  if (size >= _bufferSize) {
+    return nullptr;
+  }
+  uint8_t *block = reserve(size);
+  while (block == nullptr && !isIdle()) {
+    processEntry();
+    block = reserve(size);
+  }
+  return block;
+}
+
+
+bool AS1130AsyncBus::processEntry()
+{
+  const uint8_t *entry = _buffer + _head;
+  switch (entry[0]) {
+  case cEntryTransfer: {
+    // Send one message of the transfer. The register selection persists on
+    // the chip, so the messages do not have to be sent in one transfer.
+    const uint16_t size = entry[3] | (static_cast<uint16_t>(entry[4]) << 8);
+    if (_messageOffset == 0) {
+      _messageOffset = cTransferHeaderSize;
+    }
+    const uint8_t *data = entry + _messageOffset;
+    const uint16_t length = data[1] | (static_cast<uint16_t>(data[2]) << 8);
+    const Message message = Message::write(data[0], data + cMessageHeaderSize, length);
+    _messageOffset += cMessageHeaderSize + length;
+    if (!_bus.transfer(entry[1], &message, 1)) {
+      ++_failedTransferCount;
+      _isSuccessful = false;
+      _hasFailed = true;
+      // The following messages depend on this one, e.g. on the register selection.
+      _messageOffset = size;
+    }
+    if (_messageOffset >= size) {
+      _messageOffset = 0;
+      const uint16_t head = _head + size;
+      _head = (head == _bufferSize ? 0 : head);
+    }
+    return true;
+  }
+  case cEntryCompletion: {
+    CompletionCallback callback;
+    void *context;
+    std::memcpy(&callback, entry + 1, sizeof(callback));
+    std::memcpy(&context, entry + 1 + sizeof(callback), sizeof(context));
+    // Remove the entry first, so the callback can queue new transfers.
+    const uint16_t head = _head + 1 + sizeof(callback) + sizeof(context);
+    _head = (head == _bufferSize ? 0 : head);
+    const bool success = _isSuccessful;
+    _isSuccessful = true;
+    callback(success, context);
+    return false;
+  }
+  default:
+    // The rest of the buffer is unused.
+    _head = 0;
+    return false;
+  }
+}
+
+}
+
@@ -0,0 +1,185 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130Bus.h"
+
+
+namespace lr {
+
+
+/// @brief A bus which queues write transfers and sends them later.
+///
+/// This bus wraps another bus. Write transfers are copied into a ring buffer
+/// and return immediately. Call service() regularly, e.g. from the main loop,
+/// to send the queued messages one after the other. Each call of service()
+/// blocks for one message by default, which carries at most getMaximumDataLength()
+/// bytes, even if the driver combined several messages into one transfer. This
+/// way, the functions of the driver which only write to the chip do not block
+/// the caller.
+///
+/// Transfers which read from the chip, probes and calls to delayMs(), send all
+/// queued transfers first and then block as usual. This way, AS1130::isChipConnected()
+/// and AS1130Discovery::scan() report the real answer of the chips. If the ring
+/// buffer is full, a new transfer waits until enough queued transfers are sent.
+///
+/// Use addCompletion() after a number of driver calls to get a callback as
+/// soon as all transfers of these calls are sent. The callback reports if all
+/// transfers since the previous completion were successful. Without callbacks,
+/// use checkFailure() to detect failed transfers.
+///
+/// A queued transfer is reported as successful to the driver. The driver
+/// therefore updates its cached register selection, the shadow copy of the
+/// control registers and the memory cache, even if the transfer fails later.
+/// After a failure, call AS1130::invalidateCachedState() on each driver using
+/// this bus, which invalidates all three.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// uint8_t queueBuffer[256];
+/// lr::AS1130AsyncBus asyncBus(lr::AS1130WireBus::defaultBus(), queueBuffer, sizeof(queueBuffer));
+/// lr::AS1130 ledDriver(asyncBus);
+///
+/// void loop() {
+///   if (isNewFrameReady && asyncBus.isIdle()) {
+///     ledDriver.setOnOffFrame24x5(0, nextFrame);
+///     asyncBus.addCompletion(onFrameSent, nullptr);
+///   }
+///   asyncBus.service();
+///   if (asyncBus.checkFailure()) {
+///     ledDriver.invalidateCachedState();
+///   }
+///   // other work...
+/// }
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130AsyncBus : public AS1130Bus
+{
+public:
+  /// @brief The callback for a completion.
+  ///
+  /// @param success `true` if all transfers since the previous completion were successful.
+  /// @param context The context passed to addCompletion().
+  ///
+  typedef void (*CompletionCallback)(bool success, void *context);
+
+public:
+  /// @brief Create a new asynchronous bus.
+  ///
+  /// @param bus The bus used to send the transfers.
+  /// @param buffer The ring buffer for the queued transfers. The buffer has
+  ///   to exist as long as this instance.
+  /// @param bufferSize The size of the ring buffer in bytes.
+  ///
+  AS1130AsyncBus(AS1130Bus &bus, uint8_t *buffer, uint16_t bufferSize);
+
+public:
+  /// @brief Queue a completion callback.
+  ///
+  /// The callback is called from service() after all transfers queued before are sent.
+  ///
+  /// @param callback The function to call.
+  /// @param context A value passed to the callback.
+  ///
+  void addCompletion(CompletionCallback callback, void *context);
+
+  /// @brief Send queued messages.
+  ///
+  /// Each message is sent as a transfer of its own on the wrapped bus, and
+  /// blocks until it is sent. If a message fails, the remaining messages of
+  /// its transfer are discarded, because they depend on it.
+  ///
+  /// @param maximumMessageCount The maximum number of messages to send.
+  /// @return `true` if there are more queued messages.
+  ///
+  bool service(uint8_t maximumMessageCount = 1);
+
+  /// @brief Send all queued transfers.
+  ///
+  void flush();
+
+  /// @brief Check if the queue is empty.
+  ///
+  bool isIdle() const;
+
+  /// @brief Get the number of bytes used in the ring buffer.
+  ///
+  uint16_t getQueuedByteCount() const;
+
+  /// @brief Get the number of failed transfers since the start.
+  ///
+  uint32_t getFailedTransferCount() const;
+
+  /// @brief Check if a transfer failed since the last call.
+  ///
+  /// The flag is cleared by this call. It is independent of the status
+  /// reported to the completion callbacks.
+  ///
+  /// @return `true` if a transfer failed since the last call.
+  ///
+  bool checkFailure();
+
+public: // Implement AS1130Bus
+  bool transfer(uint8_t chipAddress, const Message *messages, uint8_t count) override;
+  uint16_t getMaximumDataLength() const override;
+  void delayMs(uint16_t milliseconds) override;
+  uint32_t getTimeUs() override;
+  bool probe(uint8_t chipAddress) override;
+
+private:
+  /// @brief Reserve a contiguous block in the ring buffer.
+  ///
+  /// @return A pointer to the block, or `nullptr` if there is not enough space.
+  ///
+  uint8_t* reserve(uint16_t size);
+
+  /// @brief Mark a reserved block as queued.
+  ///
+  void commit(uint8_t *block, uint16_t size);
+
+  /// @brief Reserve a block, send queued transfers until there is enough space.
+  ///
+  /// @return A pointer to the block, or `nullptr` if the block is larger than the ring buffer.
+  ///
+  uint8_t* reserveWaiting(uint16_t size);
+
+  /// @brief Process the entry at the head of the ring buffer.
+  ///
+  /// For a transfer, only the next message is sent.
+  ///
+  /// @return `true` if a message was sent.
+  ///
+  bool processEntry();
+
+private:
+  AS1130Bus &_bus; ///< The bus used to send the transfers.
+  uint8_t *_buffer; ///< The ring buffer.
+  uint16_t _bufferSize; ///< The size of the ring buffer.
+  volatile uint16_t _head; ///< The offset of the next entry to process.
+  volatile uint16_t _tail; ///< The offset for the next queued entry.
+  uint16_t _messageOffset; ///< The offset of the next message in the transfer at the head, zero before the first one.
+  bool _isSuccessful; ///< If all transfers since the last completion were successful.
+  uint32_t _failedTransferCount; ///< The number of failed transfers.
+  bool _hasFailed; ///< If a transfer failed since the last call of checkFailure().
+};
+
+
+}
+
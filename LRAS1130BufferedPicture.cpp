@@ -0,0 +1,79 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130BufferedPicture.h"
+
+
+namespace lr {
+
+
+AS1130BufferedPicture::AS1130BufferedPicture(AS1130 &driver, uint8_t firstFrameIndex, uint8_t frameCount)
+  : _driver(driver), _firstFrameIndex(firstFrameIndex), _frameCount(frameCount < 2 ? 2 : frameCount),
+    _displayedFrame(0), _blinkAll(false)
+{
+}
+
+
+void AS1130BufferedPicture::show24x5(const uint8_t *data, uint8_t pwmSetIndex)
+{
+  _driver.setOnOffFrame24x5(getHiddenFrameIndex(), data, pwmSetIndex);
+  flip();
+}
+
+
+void AS1130BufferedPicture::show12x11(const uint8_t *data, uint8_t pwmSetIndex)
+{
+  _driver.setOnOffFrame12x11(getHiddenFrameIndex(), data, pwmSetIndex);
+  flip();
+}
+
+
+void AS1130BufferedPicture::show(const AS1130Frame &frame)
+{
+  _driver.setOnOffFrame(getHiddenFrameIndex(), frame);
+  flip();
+}
+
+
+void AS1130BufferedPicture::setBlinkAll(bool blinkAll)
+{
+  _blinkAll = blinkAll;
+}
+
+
+uint8_t AS1130BufferedPicture::getDisplayedFrameIndex() const
+{
+  return _firstFrameIndex + _displayedFrame;
+}
+
+
+uint8_t AS1130BufferedPicture::getHiddenFrameIndex() const
+{
+  return _firstFrameIndex + ((_displayedFrame + 1) % _frameCount);
+}
+
+
+void AS1130BufferedPicture::flip()
+{
+  _displayedFrame = (_displayedFrame + 1) % _frameCount;
+  _driver.startPicture(getDisplayedFrameIndex(), _blinkAll);
+}
+
+
+}
+
@@ -0,0 +1,110 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+
+namespace lr {
+
+
+/// @brief A picture with tear-free updates using multiple frames.
+///
+/// This class uses two or more on/off frames of the chip for one picture.
+/// A new picture is written into a frame which is not displayed, then
+/// the displayed frame is changed with a single write to the picture register.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130BufferedPicture picture(ledDriver, 0);
+/// picture.show24x5(firstBitmap);
+/// ledDriver.startChip();
+/// // ...
+/// picture.show24x5(nextBitmap);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130BufferedPicture
+{
+public:
+  /// @brief Create a new buffered picture.
+  ///
+  /// This does not access the chip.
+  ///
+  /// @param driver The driver for the chip.
+  /// @param firstFrameIndex The index of the first frame used for the picture.
+  /// @param frameCount The number of consecutive frames used, at least two.
+  ///
+  AS1130BufferedPicture(AS1130 &driver, uint8_t firstFrameIndex, uint8_t frameCount = 2);
+
+public:
+  /// @brief Show a new picture from a 24x5 bitmap.
+  ///
+  /// @param data An array with 15 bytes, see AS1130::setOnOffFrame24x5().
+  /// @param pwmSetIndex The PWM set index for the picture.
+  ///
+  void show24x5(const uint8_t *data, uint8_t pwmSetIndex = 0);
+
+  /// @brief Show a new picture from a 12x11 bitmap.
+  ///
+  /// @param data An array with 22 bytes, see AS1130::setOnOffFrame12x11().
+  /// @param pwmSetIndex The PWM set index for the picture.
+  ///
+  void show12x11(const uint8_t *data, uint8_t pwmSetIndex = 0);
+
+  /// @brief Show a new picture from already converted frame data.
+  ///
+  /// @param frame The frame to show.
+  ///
+  void show(const AS1130Frame &frame);
+
+  /// @brief Set if all LEDs of the picture blink.
+  ///
+  /// The setting is used for the next call of one of the show functions.
+  ///
+  /// @param blinkAll True if all LEDs should blink.
+  ///
+  void setBlinkAll(bool blinkAll);
+
+  /// @brief Get the index of the displayed frame.
+  ///
+  /// @return The frame index, or the first frame index if no picture was shown yet.
+  ///
+  uint8_t getDisplayedFrameIndex() const;
+
+private:
+  /// @brief Get the index of the next hidden frame.
+  ///
+  uint8_t getHiddenFrameIndex() const;
+
+  /// @brief Display the hidden frame.
+  ///
+  void flip();
+
+private:
+  AS1130 &_driver; ///< The driver for the chip.
+  uint8_t _firstFrameIndex; ///< The first frame used for the picture.
+  uint8_t _frameCount; ///< The number of frames used for the picture.
+  uint8_t _displayedFrame; ///< The offset of the displayed frame.
+  bool _blinkAll; ///< If all LEDs of the picture blink.
+};
+
+
+}
+
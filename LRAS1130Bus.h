@@ -0,0 +1,130 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include <cinttypes>
+
+
+namespace lr {
+
+
+/// @brief The interface for the I2C bus used by the AS1130 driver.
+///
+/// Implement this interface to run the driver on a different I2C peripheral
+/// or platform. All accesses of the driver are expressed as a list of messages
+/// which are passed with one call to transfer(). An implementation which
+/// supports combined transfers can send all messages in one operation.
+///
+/// For Arduino compatible boards, the class AS1130WireBus implements this
+/// interface using the "Wire" library.
+///
+class AS1130Bus
+{
+public:
+  /// @brief A single message of a transfer.
+  ///
+  /// A write message sends the register address as first byte, followed by
+  /// the data bytes. A read message reads the given number of bytes from the chip.
+  ///
+  struct Message
+  {
+    /// @brief Create a write message.
+    ///
+    /// @param registerAddress The register address to send as first byte.
+    /// @param data The data bytes to send after the address.
+    /// @param length The number of data bytes. This can be zero.
+    ///
+    static Message write(uint8_t registerAddress, const uint8_t *data, uint16_t length) {
+      return Message{false, registerAddress, length, data, nullptr};
+    }
+
+    /// @brief Create a read message.
+    ///
+    /// @param data The buffer for the read bytes.
+    /// @param length The number of bytes to read.
+    ///
+    static Message read(uint8_t *data, uint16_t length) {
+      return Message{true, 0, length, nullptr, data};
+    }
+
+    bool isRead; ///< True for a read message, false for a write message.
+    uint8_t registerAddress; ///< The first byte of a write message.
+    uint16_t length; ///< The number of data bytes to write or read.
+    const uint8_t *writeData; ///< The data to write after the register address.
+    uint8_t *readData; ///< The buffer for the read data.
+  };
+
+public:
+  /// @brief Transfer a list of messages to or from the chip.
+  ///
+  /// @param chipAddress The 7-bit I2C address of the chip.
+  /// @param messages The messages to transfer, in order.
+  /// @param count The number of messages.
+  /// @return `true` on success, `false` if any of the messages failed.
+  ///
+  virtual bool transfer(uint8_t chipAddress, const Message *messages, uint8_t count) = 0;
+
+  /// @brief Get the maximum number of data bytes in one message.
+  ///
+  /// The driver splits larger blocks into multiple messages.
+  ///
+  /// @return The maximum number of data bytes, not counting the register address.
+  ///
+  virtual uint16_t getMaximumDataLength() const = 0;
+
+  /// @brief Wait for the given time.
+  ///
+  /// @param milliseconds The time to wait in milliseconds.
+  ///
+  virtual void delayMs(uint16_t milliseconds) = 0;
+
+  /// @brief Get a time stamp in microseconds.
+  ///
+  /// The time stamp is used to measure the time spent on the bus. It
+  /// can start at any value and may wrap around.
+  ///
+  /// @return The current time in microseconds.
+  ///
+  virtual uint32_t getTimeUs() = 0;
+
+  /// @brief Check if a chip answers on the bus.
+  ///
+  /// The probe sends the address of the register selection without data, so
+  /// the register selection of the chip does not change. The result has to
+  /// reflect the answer of the chip, so implementations which defer transfers
+  /// have to send the probe right away.
+  ///
+  /// @param chipAddress The 7-bit I2C address of the chip.
+  /// @return `true` if the chip acknowledged the probe.
+  ///
+  virtual bool probe(uint8_t chipAddress) {
+    const Message message = Message::write(0xfd, nullptr, 0);
+    return transfer(chipAddress, &message, 1);
+  }
+
+protected:
+  /// @brief Protected destructor, the driver never deletes a bus.
+  ///
+  ~AS1130Bus() = default;
+};
+
+
+}
+
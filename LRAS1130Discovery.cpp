@@ -0,0 +1,142 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130Discovery.h"
+
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include "LRAS1130LinuxBus.h"
+
+#include <thread>
+#include <vector>
+#endif
+
+
+namespace lr {
+
+
+namespace {
+const uint8_t cRegisterSelectionAddress = 0xfd; ///< The address of the register selection.
+}
+
+
+bool AS1130Discovery::Result::isChipFound(AS1130::ChipAddress chipAddress) const
+{
+  const uint8_t index = chipAddress - AS1130::ChipBaseAddress;
+  return index < cChipAddressCount && (chipMask & (1u << index)) != 0;
+}
+
+
+uint8_t AS1130Discovery::Result::getChipCount() const
+{
+  uint8_t count = 0;
+  for (uint8_t index = 0; index < cChipAddressCount; ++index) {
+    if ((chipMask & (1u << index)) != 0) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+
+const uint8_t* AS1130Discovery::Result::getConfiguration(AS1130::ChipAddress chipAddress) const
+{
+  if (!hasConfiguration || !isChipFound(chipAddress)) {
+    return nullptr;
+  }
+  return configuration[chipAddress - AS1130::ChipBaseAddress];
+}
+
+
+AS1130::ChipAddress AS1130Discovery::getChipAddress(uint8_t index)
+{
+  return static_cast<AS1130::ChipAddress>(AS1130::ChipBaseAddress + (index & 0x0f));
+}
+
+
+uint8_t AS1130Discovery::scan(AS1130Bus &bus, Result &result, bool readConfiguration,
+  AS1130 *const *drivers, uint8_t driverCount)
+{
+  result.chipMask = 0;
+  result.hasConfiguration = readConfiguration;
+  const uint8_t registerSelection = AS1130::RS_Control;
+  for (uint8_t index = 0; index < cChipAddressCount; ++index) {
+    uint8_t *configuration = result.configuration[index];
+    bool isFound;
+    if (readConfiguration) {
+      // The selection of the control registers is the probe, the read of the
+      // control registers follows in the same transfer.
+      const AS1130Bus::Message messages[] = {
+        AS1130Bus::Message::write(cRegisterSelectionAddress, &registerSelection, 1),
+        AS1130Bus::Message::write(AS1130::CR_Picture, nullptr, 0),
+        AS1130Bus::Message::read(configuration, cConfigurationSize),
+      };
+      isFound = bus.transfer(getChipAddress(index), messages, 3);
+    } else {
+      // The probe keeps the register selection, and is not deferred by a queuing bus.
+      isFound = bus.probe(getChipAddress(index));
+    }
+    if (isFound) {
+      result.chipMask |= (1u << index);
+    }
+    if (!isFound || !readConfiguration) {
+      for (uint8_t i = 0; i < cConfigurationSize; ++i) {
+        configuration[i] = 0;
+      }
+    }
+  }
+  if (readConfiguration) {
+    for (uint8_t i = 0; i < driverCount; ++i) {
+      drivers[i]->invalidateRegisterSelection();
+    }
+  }
+  return result.getChipCount();
+}
+
+
+#if defined(__linux__) && !defined(ARDUINO)
+uint16_t AS1130Discovery::scanLinuxBuses(const char *const *devicePaths, uint8_t busCount, Result *results,
+  bool readConfiguration, uint16_t timeoutMs)
+{
+  std::vector<std::thread> threads;
+  threads.reserve(busCount);
+  for (uint8_t busIndex = 0; busIndex < busCount; ++busIndex) {
+    threads.emplace_back([=]() {
+      Result &result = results[busIndex];
+      AS1130LinuxBus bus(devicePaths[busIndex]);
+      bus.setTimeout(timeoutMs);
+      if (bus.open()) {
+        scan(bus, result, readConfiguration);
+      } else {
+        result.chipMask = 0;
+        result.hasConfiguration = false;
+      }
+    });
+  }
+  uint16_t count = 0;
+  for (uint8_t busIndex = 0; busIndex < busCount; ++busIndex) {
+    threads[busIndex].join();
+    count += results[busIndex].getChipCount();
+  }
+  return count;
+}
+#endif
+
+
+}
+
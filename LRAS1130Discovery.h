@@ -0,0 +1,135 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+
+namespace lr {
+
+
+/// @brief Find all AS1130 chips on a bus.
+///
+/// The scan probes all 16 chip addresses, each with a single transfer. The
+/// probe uses AS1130Bus::probe(), which only sends the address of the register
+/// selection, without data, so it changes nothing on the chip. A queuing bus
+/// like AS1130AsyncBus sends the probes right away. If requested, the probe is
+/// replaced by a transfer which also reads the control registers of each chip,
+/// which tell how the chip is configured.
+///
+/// Set a short timeout on the bus before the scan, e.g. with
+/// AS1130LinuxBus::setTimeout(), to limit the time spent on a blocked bus.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130Discovery::Result result;
+/// lr::AS1130Discovery::scan(bus, result);
+/// for (uint8_t i = 0; i < 16; ++i) {
+///   if (result.isChipFound(lr::AS1130Discovery::getChipAddress(i))) {
+///     // ...
+///   }
+/// }
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130Discovery
+{
+public:
+  /// @brief The number of possible chip addresses.
+  ///
+  static const uint8_t cChipAddressCount = 16;
+
+  /// @brief The number of control registers read for each chip.
+  ///
+  /// This are the registers from CR_Picture to CR_ClockSynchronization.
+  ///
+  static const uint8_t cConfigurationSize = AS1130::CR_ClockSynchronization + 1;
+
+  /// @brief The result of a scan.
+  ///
+  struct Result {
+    /// @brief Check if a chip answered.
+    ///
+    bool isChipFound(AS1130::ChipAddress chipAddress) const;
+
+    /// @brief Get the number of found chips.
+    ///
+    uint8_t getChipCount() const;
+
+    /// @brief Get the control registers of a found chip.
+    ///
+    /// @return An array with the control registers, or `nullptr` if the chip
+    ///   was not found or the configuration was not read.
+    ///
+    const uint8_t* getConfiguration(AS1130::ChipAddress chipAddress) const;
+
+    uint16_t chipMask; ///< One bit for each found chip, bit 0 for ChipAddress0.
+    bool hasConfiguration; ///< If the configuration was read.
+    uint8_t configuration[cChipAddressCount][cConfigurationSize]; ///< The control registers of the found chips.
+  };
+
+public:
+  /// @brief Get the chip address for an index.
+  ///
+  /// @param index The index from 0 to 15.
+  ///
+  static AS1130::ChipAddress getChipAddress(uint8_t index);
+
+  /// @brief Scan one bus for chips.
+  ///
+  /// Reading the configuration selects the control registers on all found
+  /// chips. Every driver for a chip on this bus then has a wrong cached register
+  /// selection, and has to call AS1130::invalidateRegisterSelection() before it
+  /// is used again. Pass the drivers to this function to do this automatically,
+  /// or use AS1130Array::invalidateRegisterSelection(). A scan without reading
+  /// the configuration does not change the register selection.
+  ///
+  /// @param bus The bus to scan.
+  /// @param result The result of the scan.
+  /// @param readConfiguration True to read the control registers of the found chips.
+  /// @param drivers An optional array with the drivers for chips on this bus.
+  /// @param driverCount The number of drivers in the array.
+  /// @return The number of found chips.
+  ///
+  static uint8_t scan(AS1130Bus &bus, Result &result, bool readConfiguration = false,
+    AS1130 *const *drivers = nullptr, uint8_t driverCount = 0);
+
+#if defined(__linux__) && !defined(ARDUINO)
+  /// @brief Scan multiple Linux I2C buses at the same time.
+  ///
+  /// Each bus is opened and scanned in an own thread. Link with `-pthread`.
+  /// If the configuration is read, all drivers for chips on these buses have
+  /// to call AS1130::invalidateRegisterSelection() afterwards, see scan().
+  ///
+  /// @param devicePaths The paths to the I2C devices, e.g. `/dev/i2c-1`.
+  /// @param busCount The number of buses.
+  /// @param results An array with one result for each bus. The result of a
+  ///   bus which could not be opened contains no chips.
+  /// @param readConfiguration True to read the control registers of the found chips.
+  /// @param timeoutMs The timeout for each transfer in milliseconds.
+  /// @return The number of found chips on all buses.
+  ///
+  static uint16_t scanLinuxBuses(const char *const *devicePaths, uint8_t busCount, Result *results,
+    bool readConfiguration = false, uint16_t timeoutMs = 10);
+#endif
+};
+
+
+}
+
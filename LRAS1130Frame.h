@@ -0,0 +1,144 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include <cinttypes>
+
+
+namespace lr {
+
+
+/// @brief An on/off frame in the data layout of the chip.
+///
+/// Frames of this type can be created at compile time from a bitmap, so no
+/// conversion is required at runtime. If the frame is declared `constexpr`,
+/// it is placed in flash memory on the supported boards and can be passed
+/// directly to AS1130::setOnOffFrame().
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// constexpr uint8_t exampleBitmap[] = {
+///   0b11111111, 0b11111111, 0b11111111,
+///   0b10000000, 0b00000000, 0b00000001,
+///   0b10000000, 0b00000000, 0b00000001,
+///   0b10000000, 0b00000000, 0b00000001,
+///   0b11111111, 0b11111111, 0b11111111};
+/// constexpr lr::AS1130Frame exampleFrame = lr::AS1130Frame::from24x5(exampleBitmap);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+struct AS1130Frame
+{
+  /// @brief Create a frame from a 24x5 bitmap.
+  ///
+  /// The result is the same as from AS1130::encodeFrame24x5().
+  ///
+  /// @param bitmap The bitmap in the format described for AS1130::setOnOffFrame24x5().
+  /// @param pwmSetIndex The PWM set index for this frame.
+  ///
+  static constexpr AS1130Frame from24x5(const uint8_t (&bitmap)[15], uint8_t pwmSetIndex = 0);
+
+  /// @brief Create a frame from a 12x11 bitmap.
+  ///
+  /// The result is the same as from AS1130::encodeFrame12x11().
+  ///
+  /// @param bitmap The bitmap in the format described for AS1130::setOnOffFrame12x11().
+  /// @param pwmSetIndex The PWM set index for this frame.
+  ///
+  static constexpr AS1130Frame from12x11(const uint8_t (&bitmap)[22], uint8_t pwmSetIndex = 0);
+
+  uint8_t data[0x18]; ///< The 24 bytes of the frame, as written to the chip.
+
+private:
+  /// Get the bit for a LED of a segment from a 24x5 bitmap.
+  ///
+  /// Each segment contains two columns with five LEDs.
+  ///
+  static constexpr uint8_t ledBit24x5(const uint8_t (&bitmap)[15], uint8_t segment, uint8_t led) {
+    return (bitmap[(led%5)*3 + ((segment*2+led/5)>>3)] >> (7-((segment*2+led/5)&7))) & 1;
+  }
+
+  /// Get the bit for a LED of a segment from a 12x11 bitmap.
+  ///
+  /// Each segment is one column of the matrix.
+  ///
+  static constexpr uint8_t ledBit12x11(const uint8_t (&bitmap)[22], uint8_t segment, uint8_t led) {
+    return (bitmap[led*2 + (segment>>3)] >> (7-(segment&7))) & 1;
+  }
+
+  /// Collect the bits for the LEDs from `led` to `end` of a segment from a 24x5 bitmap.
+  ///
+  static constexpr uint8_t ledBits24x5(const uint8_t (&bitmap)[15], uint8_t segment, uint8_t led, uint8_t end) {
+    return led >= end ? 0 : static_cast<uint8_t>((ledBit24x5(bitmap, segment, led) << (led&7)) | ledBits24x5(bitmap, segment, led+1, end));
+  }
+
+  /// Collect the bits for the LEDs from `led` to `end` of a segment from a 12x11 bitmap.
+  ///
+  static constexpr uint8_t ledBits12x11(const uint8_t (&bitmap)[22], uint8_t segment, uint8_t led, uint8_t end) {
+    return led >= end ? 0 : static_cast<uint8_t>((ledBit12x11(bitmap, segment, led) << (led&7)) | ledBits12x11(bitmap, segment, led+1, end));
+  }
+
+  /// Get the PWM set bits for the given frame byte.
+  ///
+  static constexpr uint8_t pwmSetBits(uint8_t index, uint8_t pwmSetIndex) {
+    return index == 1 ? static_cast<uint8_t>(pwmSetIndex<<5) : 0;
+  }
+
+  /// Get a byte of the frame from a 24x5 bitmap.
+  ///
+  static constexpr uint8_t byte24x5(const uint8_t (&bitmap)[15], uint8_t index, uint8_t pwmSetIndex) {
+    return (index & 1) == 0 ? ledBits24x5(bitmap, index/2, 0, 8)
+      : static_cast<uint8_t>(ledBits24x5(bitmap, index/2, 8, 10) | pwmSetBits(index, pwmSetIndex));
+  }
+
+  /// Get a byte of the frame from a 12x11 bitmap.
+  ///
+  static constexpr uint8_t byte12x11(const uint8_t (&bitmap)[22], uint8_t index, uint8_t pwmSetIndex) {
+    return (index & 1) == 0 ? ledBits12x11(bitmap, index/2, 0, 8)
+      : static_cast<uint8_t>(ledBits12x11(bitmap, index/2, 8, 11) | pwmSetBits(index, pwmSetIndex));
+  }
+};
+
+
+constexpr AS1130Frame AS1130Frame::from24x5(const uint8_t (&bitmap)[15], uint8_t pwmSetIndex)
+{
+  return AS1130Frame{{
+    byte24x5(bitmap, 0, pwmSetIndex), byte24x5(bitmap, 1, pwmSetIndex), byte24x5(bitmap, 2, pwmSetIndex), byte24x5(bitmap, 3, pwmSetIndex),
+    byte24x5(bitmap, 4, pwmSetIndex), byte24x5(bitmap, 5, pwmSetIndex), byte24x5(bitmap, 6, pwmSetIndex), byte24x5(bitmap, 7, pwmSetIndex),
+    byte24x5(bitmap, 8, pwmSetIndex), byte24x5(bitmap, 9, pwmSetIndex), byte24x5(bitmap, 10, pwmSetIndex), byte24x5(bitmap, 11, pwmSetIndex),
+    byte24x5(bitmap, 12, pwmSetIndex), byte24x5(bitmap, 13, pwmSetIndex), byte24x5(bitmap, 14, pwmSetIndex), byte24x5(bitmap, 15, pwmSetIndex),
+    byte24x5(bitmap, 16, pwmSetIndex), byte24x5(bitmap, 17, pwmSetIndex), byte24x5(bitmap, 18, pwmSetIndex), byte24x5(bitmap, 19, pwmSetIndex),
+    byte24x5(bitmap, 20, pwmSetIndex), byte24x5(bitmap, 21, pwmSetIndex), byte24x5(bitmap, 22, pwmSetIndex), byte24x5(bitmap, 23, pwmSetIndex)}};
+}
+
+
+constexpr AS1130Frame AS1130Frame::from12x11(const uint8_t (&bitmap)[22], uint8_t pwmSetIndex)
+{
+  return AS1130Frame{{
+    byte12x11(bitmap, 0, pwmSetIndex), byte12x11(bitmap, 1, pwmSetIndex), byte12x11(bitmap, 2, pwmSetIndex), byte12x11(bitmap, 3, pwmSetIndex),
+    byte12x11(bitmap, 4, pwmSetIndex), byte12x11(bitmap, 5, pwmSetIndex), byte12x11(bitmap, 6, pwmSetIndex), byte12x11(bitmap, 7, pwmSetIndex),
+    byte12x11(bitmap, 8, pwmSetIndex), byte12x11(bitmap, 9, pwmSetIndex), byte12x11(bitmap, 10, pwmSetIndex), byte12x11(bitmap, 11, pwmSetIndex),
+    byte12x11(bitmap, 12, pwmSetIndex), byte12x11(bitmap, 13, pwmSetIndex), byte12x11(bitmap, 14, pwmSetIndex), byte12x11(bitmap, 15, pwmSetIndex),
+    byte12x11(bitmap, 16, pwmSetIndex), byte12x11(bitmap, 17, pwmSetIndex), byte12x11(bitmap, 18, pwmSetIndex), byte12x11(bitmap, 19, pwmSetIndex),
+    byte12x11(bitmap, 20, pwmSetIndex), byte12x11(bitmap, 21, pwmSetIndex), byte12x11(bitmap, 22, pwmSetIndex), byte12x11(bitmap, 23, pwmSetIndex)}};
+}
+
+
+}
+
@@ -0,0 +1,328 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130GrayscalePacker.h"
+
+
+#include "LRAS1130RamAllocator.h"
+
+#include <cstring>
+
+
+namespace lr {
+
+
+namespace {
+const uint8_t cMaximumFrameCount = 36; ///< The maximum number of frames.
+const uint8_t cMaximumPwmSetCount = 6; ///< The maximum number of PWM sets.
+const uint8_t cPwmValueCount = 132; ///< The number of PWM values in a set.
+const uint8_t cMaximumIterationCount = 8; ///< The maximum number of iterations for the clustering.
+}
+
+
+AS1130GrayscalePacker::AS1130GrayscalePacker(Layout layout, uint16_t levelCount, bool isDotCorrectionUsed)
+  : _layout(layout), _levelCount(levelCount < 2 ? 2 : (levelCount > 256 ? 256 : levelCount)),
+    _isDotCorrectionUsed(isDotCorrectionUsed), _frames(nullptr), _frameCount(0), _firstFrameIndex(0),
+    _ramConfiguration(AS1130::RamConfiguration1), _pwmSetCount(0)
+{
+  std::memset(_framePwmSet, 0, sizeof(_framePwmSet));
+  std::memset(_pwmValues, 0, sizeof(_pwmValues));
+  std::memset(_pwmValueUsage, 0, sizeof(_pwmValueUsage));
+}
+
+
+bool AS1130GrayscalePacker::pack(const uint8_t *frames, uint8_t frameCount, uint8_t firstFrameIndex)
+{
+  const uint16_t requiredFrameCount = static_cast<uint16_t>(firstFrameIndex) + frameCount;
+  if (frameCount == 0 || requiredFrameCount > AS1130RamAllocator::getFrameCount(AS1130::RamConfiguration1, _isDotCorrectionUsed)) {
+    return false;
+  }
+  _frames = frames;
+  _frameCount = frameCount;
+  _firstFrameIndex = firstFrameIndex;
+  // Use the configuration with the most sets which still holds all frames.
+  _ramConfiguration = AS1130::RamConfiguration1;
+  for (uint8_t configuration = AS1130::RamConfiguration6; configuration > AS1130::RamConfiguration1; --configuration) {
+    if (AS1130RamAllocator::getFrameCount(static_cast<AS1130::RamConfiguration>(configuration), _isDotCorrectionUsed) >= requiredFrameCount) {
+      _ramConfiguration = static_cast<AS1130::RamConfiguration>(configuration);
+      break;
+    }
+  }
+  const uint8_t maximumSetCount = AS1130RamAllocator::getPwmSetCount(_ramConfiguration);
+  // Start with the brightest frame, so the first set is not empty if the
+  // animation starts with a blank frame. Then choose the initial sets, each
+  // time using the frame with the largest error. Identical frames have no
+  // error, so they never get an own set.
+  std::memset(_pwmValues, 0, sizeof(_pwmValues));
+  std::memset(_pwmValueUsage, 0, sizeof(_pwmValueUsage));
+  copyFrameToSet(getBrightestFrame(), 0);
+  _pwmSetCount = 1;
+  while (_pwmSetCount < maximumSetCount) {
+    uint32_t largestDistance = 0;
+    uint8_t farthestFrame = 0;
+    for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+      uint32_t distance;
+      getNearestSet(frameIndex, &distance);
+      if (distance > largestDistance) {
+        largestDistance = distance;
+        farthestFrame = frameIndex;
+      }
+    }
+    if (largestDistance == 0) {
+      break;
+    }
+    copyFrameToSet(farthestFrame, _pwmSetCount);
+    ++_pwmSetCount;
+  }
+  // Refine the sets with a few k-means iterations.
+  for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+    _framePwmSet[frameIndex] = getNearestSet(frameIndex, nullptr);
+  }
+  bool isChanged = true;
+  for (uint8_t iteration = 0; iteration < cMaximumIterationCount && isChanged; ++iteration) {
+    for (uint8_t setIndex = 0; setIndex < _pwmSetCount; ++setIndex) {
+      updateSet(setIndex);
+    }
+    isChanged = false;
+    for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+      const uint8_t setIndex = getNearestSet(frameIndex, nullptr);
+      if (setIndex != _framePwmSet[frameIndex]) {
+        _framePwmSet[frameIndex] = setIndex;
+        isChanged = true;
+      }
+    }
+  }
+  if (isChanged) {
+    // Make sure each set has values for all LEDs of its frames.
+    for (uint8_t setIndex = 0; setIndex < _pwmSetCount; ++setIndex) {
+      updateSet(setIndex);
+    }
+  }
+  return true;
+}
+
+
+void AS1130GrayscalePacker::upload(AS1130 &driver) const
+{
+  driver.setRamConfiguration(_ramConfiguration);
+  for (uint8_t setIndex = 0; setIndex < _pwmSetCount; ++setIndex) {
+    driver.setPwmValues(setIndex, _pwmValues[setIndex]);
+  }
+  AS1130Frame frame;
+  for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+    getFrame(frameIndex, frame);
+    driver.setOnOffFrame(_firstFrameIndex + frameIndex, frame);
+  }
+}
+
+
+AS1130::RamConfiguration AS1130GrayscalePacker::getRamConfiguration() const
+{
+  return _ramConfiguration;
+}
+
+
+uint8_t AS1130GrayscalePacker::getFirstFrameIndex() const
+{
+  return _firstFrameIndex;
+}
+
+
+uint8_t AS1130GrayscalePacker::getPwmSetCount() const
+{
+  return _pwmSetCount;
+}
+
+
+uint8_t AS1130GrayscalePacker::getFramePwmSetIndex(uint8_t frameIndex) const
+{
+  return frameIndex < _frameCount ? _framePwmSet[frameIndex] : 0;
+}
+
+
+const uint8_t* AS1130GrayscalePacker::getPwmValues(uint8_t setIndex) const
+{
+  return _pwmValues[setIndex < cMaximumPwmSetCount ? setIndex : 0];
+}
+
+
+void AS1130GrayscalePacker::getFrame(uint8_t frameIndex, AS1130Frame &frame) const
+{
+  std::memset(frame.data, 0, sizeof(frame.data));
+  const uint8_t pixelCount = getPixelCount();
+  for (uint8_t pixelIndex = 0; pixelIndex < pixelCount; ++pixelIndex) {
+    if (getQuantizedValue(frameIndex, pixelIndex) != 0) {
+      const uint8_t valueIndex = getValueIndex(pixelIndex);
+      const uint8_t segment = valueIndex / 11;
+      const uint8_t led = valueIndex % 11;
+      frame.data[(segment<<1) + (led>>3)] |= (1<<(led&0x07));
+    }
+  }
+  frame.data[1] |= (_framePwmSet[frameIndex]<<5);
+}
+
+
+uint8_t AS1130GrayscalePacker::getPixelCount() const
+{
+  return _layout == Layout24x5 ? 120 : 132;
+}
+
+
+uint8_t AS1130GrayscalePacker::getValueIndex(uint8_t pixelIndex) const
+{
+  uint8_t ledIndex;
+  if (_layout == Layout24x5) {
+    ledIndex = AS1130::getLedIndex24x5(pixelIndex % 24, pixelIndex / 24);
+  } else {
+    ledIndex = AS1130::getLedIndex12x11(pixelIndex % 12, pixelIndex / 12);
+  }
+  return ((ledIndex>>4) * 11) + (ledIndex&0x0f);
+}
+
+
+uint8_t AS1130GrayscalePacker::getQuantizedValue(uint8_t frameIndex, uint8_t pixelIndex) const
+{
+  return quantize(_frames[static_cast<uint16_t>(frameIndex) * getPixelCount() + pixelIndex]);
+}
+
+
+uint8_t AS1130GrayscalePacker::quantize(uint8_t value) const
+{
+  const uint16_t maximumLevel = _levelCount - 1;
+  const uint16_t level = (static_cast<uint16_t>(value) * maximumLevel + 127) / 255;
+  return static_cast<uint8_t>((level * 255 + maximumLevel / 2) / maximumLevel);
+}
+
+
+uint32_t AS1130GrayscalePacker::getDistance(uint8_t frameIndex, uint8_t setIndex) const
+{
+  // LEDs which are off in the frame do not care about their PWM value, and
+  // values which are not used by any frame of the set can take any value.
+  uint32_t distance = 0;
+  const uint8_t pixelCount = getPixelCount();
+  for (uint8_t pixelIndex = 0; pixelIndex < pixelCount; ++pixelIndex) {
+    const uint8_t value = getQuantizedValue(frameIndex, pixelIndex);
+    const uint8_t valueIndex = getValueIndex(pixelIndex);
+    if (value != 0 && isValueUsed(setIndex, valueIndex)) {
+      const int16_t difference = static_cast<int16_t>(value) - _pwmValues[setIndex][valueIndex];
+      distance += static_cast<uint32_t>(difference * difference);
+    }
+  }
+  return distance;
+}
+
+
+uint8_t AS1130GrayscalePacker::getNearestSet(uint8_t frameIndex, uint32_t *distance) const
+{
+  uint8_t result = 0;
+  uint32_t smallestDistance = 0xffffffff;
+  for (uint8_t setIndex = 0; setIndex < _pwmSetCount; ++setIndex) {
+    const uint32_t setDistance = getDistance(frameIndex, setIndex);
+    if (setDistance < smallestDistance) {
+      smallestDistance = setDistance;
+      result = setIndex;
+    }
+  }
+  if (distance != nullptr) {
+    *distance = smallestDistance;
+  }
+  return result;
+}
+
+
+void AS1130GrayscalePacker::copyFrameToSet(uint8_t frameIndex, uint8_t setIndex)
+{
+  const uint8_t pixelCount = getPixelCount();
+  for (uint8_t pixelIndex = 0; pixelIndex < pixelCount; ++pixelIndex) {
+    const uint8_t valueIndex = getValueIndex(pixelIndex);
+    const uint8_t value = getQuantizedValue(frameIndex, pixelIndex);
+    _pwmValues[setIndex][valueIndex] = value;
+    setValueUsed(setIndex, valueIndex, value != 0);
+  }
+}
+
+
+void AS1130GrayscalePacker::updateSet(uint8_t setIndex)
+{
+  uint16_t sum[cPwmValueCount];
+  uint8_t count[cPwmValueCount];
+  std::memset(sum, 0, sizeof(sum));
+  std::memset(count, 0, sizeof(count));
+  const uint8_t pixelCount = getPixelCount();
+  for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+    if (_framePwmSet[frameIndex] != setIndex) {
+      continue;
+    }
+    for (uint8_t pixelIndex = 0; pixelIndex < pixelCount; ++pixelIndex) {
+      const uint8_t value = getQuantizedValue(frameIndex, pixelIndex);
+      if (value != 0) {
+        const uint8_t valueIndex = getValueIndex(pixelIndex);
+        sum[valueIndex] += value;
+        ++count[valueIndex];
+      }
+    }
+  }
+  for (uint8_t valueIndex = 0; valueIndex < cPwmValueCount; ++valueIndex) {
+    if (count[valueIndex] != 0) {
+      const uint8_t mean = static_cast<uint8_t>((sum[valueIndex] + count[valueIndex] / 2) / count[valueIndex]);
+      _pwmValues[setIndex][valueIndex] = quantize(mean);
+      setValueUsed(setIndex, valueIndex, true);
+    } else {
+      _pwmValues[setIndex][valueIndex] = 0;
+      setValueUsed(setIndex, valueIndex, false);
+    }
+  }
+}
+
+
+uint8_t AS1130GrayscalePacker::getBrightestFrame() const
+{
+  uint8_t result = 0;
+  uint32_t largestSum = 0;
+  const uint8_t pixelCount = getPixelCount();
+  for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+    uint32_t sum = 0;
+    for (uint8_t pixelIndex = 0; pixelIndex < pixelCount; ++pixelIndex) {
+      sum += getQuantizedValue(frameIndex, pixelIndex);
+    }
+    if (sum > largestSum) {
+      largestSum = sum;
+      result = frameIndex;
+    }
+  }
+  return result;
+}
+
+
+bool AS1130GrayscalePacker::isValueUsed(uint8_t setIndex, uint8_t valueIndex) const
+{
+  return (_pwmValueUsage[setIndex][valueIndex>>3] & (1<<(valueIndex&0x07))) != 0;
+}
+
+
+void AS1130GrayscalePacker::setValueUsed(uint8_t setIndex, uint8_t valueIndex, bool used)
+{
+  if (used) {
+    _pwmValueUsage[setIndex][valueIndex>>3] |= (1<<(valueIndex&0x07));
+  } else {
+    _pwmValueUsage[setIndex][valueIndex>>3] &= ~(1<<(valueIndex&0x07));
+  }
+}
+
+
+}
@@ -0,0 +1,186 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+
+namespace lr {
+
+
+/// @brief Pack a grayscale animation into on/off frames and blink&PWM sets.
+///
+/// Each on/off frame of the chip references one of at most six blink&PWM sets.
+/// This class converts a grayscale animation into frames which share a small
+/// number of PWM sets, so the chip can play it as movie without help of the CPU.
+///
+/// The brightness of each frame is quantized to the given number of levels.
+/// LEDs with a brightness of zero are switched off in the on/off frame. The
+/// brightness maps of all frames are clustered into as many PWM sets as the
+/// RAM configuration allows. Identical maps always share one set. The RAM
+/// configuration with the most PWM sets which still holds all frames at the
+/// given position is chosen.
+///
+/// The animation data is not copied, it has to stay valid until upload() is called.
+/// An instance uses about 950 bytes of RAM for the PWM sets, and pack() needs
+/// about 400 bytes of stack.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130GrayscalePacker packer(lr::AS1130GrayscalePacker::Layout24x5);
+/// if (packer.pack(animation, 20, 4)) {
+///   packer.upload(ledDriver);
+///   ledDriver.setMovieFrameCount(20);
+///   ledDriver.startMovie(4);
+/// }
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130GrayscalePacker
+{
+public:
+  /// @brief The layout of the grayscale frames.
+  ///
+  enum Layout : uint8_t {
+    Layout24x5, ///< 120 values per frame, the value for x/y is at index `y*24+x`.
+    Layout12x11, ///< 132 values per frame, the value for x/y is at index `y*12+x`.
+  };
+
+public:
+  /// @brief Create a new packer.
+  ///
+  /// @param layout The layout of the grayscale frames.
+  /// @param levelCount The number of brightness levels, between 2 and 256.
+  /// @param isDotCorrectionUsed If the dot correction is used, which reserves the last frame.
+  ///
+  explicit AS1130GrayscalePacker(Layout layout, uint16_t levelCount = 16, bool isDotCorrectionUsed = false);
+
+public:
+  /// @brief Pack a grayscale animation.
+  ///
+  /// @param frames The brightness values of all frames, one frame after the other.
+  /// @param frameCount The number of frames.
+  /// @param firstFrameIndex The index of the on/off frame for the first frame of the animation.
+  /// @return `true` on success, `false` if the frames do not fit into the chip at this position.
+  ///
+  bool pack(const uint8_t *frames, uint8_t frameCount, uint8_t firstFrameIndex = 0);
+
+  /// @brief Upload the packed animation to the chip.
+  ///
+  /// This sets the RAM configuration and writes the PWM values of all used
+  /// sets and all on/off frames, each with one burst. The frames are written
+  /// starting with the first frame index passed to pack(). The blink bits of
+  /// the sets are not changed.
+  ///
+  /// @param driver The driver for the chip.
+  ///
+  void upload(AS1130 &driver) const;
+
+  /// @brief Get the chosen RAM configuration.
+  ///
+  AS1130::RamConfiguration getRamConfiguration() const;
+
+  /// @brief Get the index of the on/off frame for the first frame of the animation.
+  ///
+  uint8_t getFirstFrameIndex() const;
+
+  /// @brief Get the number of used PWM sets.
+  ///
+  uint8_t getPwmSetCount() const;
+
+  /// @brief Get the PWM set used by a frame.
+  ///
+  uint8_t getFramePwmSetIndex(uint8_t frameIndex) const;
+
+  /// @brief Get the PWM values of a set in the order of the chip.
+  ///
+  /// @param setIndex The index of the set.
+  /// @return An array with 132 PWM values, see AS1130::setPwmValues().
+  ///
+  const uint8_t* getPwmValues(uint8_t setIndex) const;
+
+  /// @brief Convert a frame to the format of the chip.
+  ///
+  /// @param frameIndex The index of the frame in the animation.
+  /// @param frame The frame to fill.
+  ///
+  void getFrame(uint8_t frameIndex, AS1130Frame &frame) const;
+
+private:
+  /// @brief Get the number of values of each frame.
+  ///
+  uint8_t getPixelCount() const;
+
+  /// @brief Get the index in the order of the chip for a pixel.
+  ///
+  uint8_t getValueIndex(uint8_t pixelIndex) const;
+
+  /// @brief Get a quantized value of a frame.
+  ///
+  uint8_t getQuantizedValue(uint8_t frameIndex, uint8_t pixelIndex) const;
+
+  /// @brief Quantize a brightness value.
+  ///
+  uint8_t quantize(uint8_t value) const;
+
+  /// @brief Get the error if a frame uses a PWM set.
+  ///
+  uint32_t getDistance(uint8_t frameIndex, uint8_t setIndex) const;
+
+  /// @brief Get the set with the smallest error for a frame.
+  ///
+  uint8_t getNearestSet(uint8_t frameIndex, uint32_t *distance) const;
+
+  /// @brief Copy the quantized values of a frame into a PWM set.
+  ///
+  void copyFrameToSet(uint8_t frameIndex, uint8_t setIndex);
+
+  /// @brief Set the values of a PWM set to the mean of its frames.
+  ///
+  void updateSet(uint8_t setIndex);
+
+  /// @brief Get the frame with the largest sum of brightness values.
+  ///
+  uint8_t getBrightestFrame() const;
+
+  /// @brief Check if a value of a PWM set is used by any frame of the set.
+  ///
+  bool isValueUsed(uint8_t setIndex, uint8_t valueIndex) const;
+
+  /// @brief Mark a value of a PWM set as used or unused.
+  ///
+  void setValueUsed(uint8_t setIndex, uint8_t valueIndex, bool used);
+
+private:
+  Layout _layout; ///< The layout of the frames.
+  uint16_t _levelCount; ///< The number of brightness levels.
+  bool _isDotCorrectionUsed; ///< If the dot correction is used.
+  const uint8_t *_frames; ///< The packed frames.
+  uint8_t _frameCount; ///< The number of packed frames.
+  uint8_t _firstFrameIndex; ///< The on/off frame for the first packed frame.
+  AS1130::RamConfiguration _ramConfiguration; ///< The chosen RAM configuration.
+  uint8_t _pwmSetCount; ///< The number of used PWM sets.
+  uint8_t _framePwmSet[36]; ///< The PWM set for each frame.
+  uint8_t _pwmValues[6][132]; ///< The PWM values of the sets, in the order of the chip.
+  uint8_t _pwmValueUsage[6][17]; ///< One bit for each PWM value which is lit by a frame of the set.
+};
+
+
+}
+
@@ -0,0 +1,188 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#if defined(__linux__) && !defined(ARDUINO)
+
+
+#include "LRAS1130LinuxBus.h"
+
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+
+namespace lr {
+
+
+namespace {
+
+
+/// The maximum number of messages the kernel accepts in one I2C_RDWR call.
+///
+#if defined(I2C_RDWR_IOCTL_MAX_MSGS)
+const uint8_t cMaximumMessageCount = I2C_RDWR_IOCTL_MAX_MSGS;
+#else
+const uint8_t cMaximumMessageCount = 42;
+#endif
+
+/// The maximum number of data bytes in one message.
+///
+/// This covers the whole address range of a register bank.
+///
+const uint16_t cMaximumDataLength = 0x100;
+
+
+}
+
+
+AS1130LinuxBus::AS1130LinuxBus(const char *devicePath)
+  : _devicePath(devicePath), _fileDescriptor(-1), _timeoutMs(0)
+{
+}
+
+
+AS1130LinuxBus::~AS1130LinuxBus()
+{
+  close();
+}
+
+
+bool AS1130LinuxBus::open()
+{
+  close();
+  _fileDescriptor = ::open(_devicePath, O_RDWR);
+  if (_fileDescriptor < 0) {
+    return false;
+  }
+  if (_timeoutMs > 0) {
+    setTimeout(_timeoutMs);
+  }
+  return true;
+}
+
+
+void AS1130LinuxBus::close()
+{
+  if (_fileDescriptor >= 0) {
+    ::close(_fileDescriptor);
+    _fileDescriptor = -1;
+  }
+}
+
+
+bool AS1130LinuxBus::isOpen() const
+{
+  return _fileDescriptor >= 0;
+}
+
+
+void AS1130LinuxBus::setTimeout(uint16_t milliseconds)
+{
+  _timeoutMs = milliseconds;
+  if (_fileDescriptor >= 0 && milliseconds > 0) {
+    // The timeout is specified in units of 10 ms.
+    const unsigned long timeout = (milliseconds + 9) / 10;
+    ioctl(_fileDescriptor, I2C_TIMEOUT, timeout);
+  }
+}
+
+
+bool AS1130LinuxBus::transfer(uint8_t chipAddress, const Message *messages, uint8_t count)
+{
+  if (_fileDescriptor < 0) {
+    return false;
+  }
+  // Copy the register address and data of all write messages into one buffer.
+  std::size_t writeSize = 0;
+  for (uint8_t i = 0; i < count; ++i) {
+    if (!messages[i].isRead) {
+      writeSize += messages[i].length + 1;
+    }
+  }
+  _writeBuffer.resize(writeSize);
+  uint8_t *writeData = _writeBuffer.data();
+  struct i2c_msg kernelMessages[cMaximumMessageCount];
+  uint8_t kernelCount = 0;
+  for (uint8_t i = 0; i < count; ++i) {
+    const Message &message = messages[i];
+    struct i2c_msg &kernelMessage = kernelMessages[kernelCount++];
+    kernelMessage.addr = chipAddress;
+    if (message.isRead) {
+      kernelMessage.flags = I2C_M_RD;
+      kernelMessage.len = message.length;
+      kernelMessage.buf = message.readData;
+    } else {
+      writeData[0] = message.registerAddress;
+      if (message.length > 0) {
+        std::memcpy(writeData + 1, message.writeData, message.length);
+      }
+      kernelMessage.flags = 0;
+      kernelMessage.len = message.length + 1;
+      kernelMessage.buf = writeData;
+      writeData += message.length + 1;
+    }
+    // Send the messages if the kernel limit is reached or all messages are prepared.
+    if (kernelCount == cMaximumMessageCount || i + 1 == count) {
+      struct i2c_rdwr_ioctl_data data;
+      data.msgs = kernelMessages;
+      data.nmsgs = kernelCount;
+      if (ioctl(_fileDescriptor, I2C_RDWR, &data) < 0) {
+        return false;
+      }
+      kernelCount = 0;
+    }
+  }
+  return true;
+}
+
+
+uint16_t AS1130LinuxBus::getMaximumDataLength() const
+{
+  return cMaximumDataLength;
+}
+
+
+void AS1130LinuxBus::delayMs(uint16_t milliseconds)
+{
+  struct timespec duration;
+  duration.tv_sec = milliseconds / 1000;
+  duration.tv_nsec = static_cast<long>(milliseconds % 1000) * 1000000L;
+  while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+  }
+}
+
+
+uint32_t AS1130LinuxBus::getTimeUs()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint32_t>(now.tv_sec * 1000000ULL + now.tv_nsec / 1000);
+}
+
+
+}
+
+
+#endif
+
@@ -0,0 +1,102 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130Bus.h"
+
+#include <vector>
+
+
+namespace lr {
+
+
+/// @brief The AS1130 bus implementation for the Linux i2c-dev interface.
+///
+/// This bus opens a `/dev/i2c-N` device and passes all messages of one
+/// transfer with a single `I2C_RDWR` call to the kernel. The messages are
+/// sent as one combined transaction, separated by repeated starts.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130LinuxBus bus("/dev/i2c-1");
+/// if (!bus.open()) {
+///   // handle the error
+/// }
+/// lr::AS1130 ledDriver(bus);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130LinuxBus : public AS1130Bus
+{
+public:
+  /// @brief Create a new bus instance.
+  ///
+  /// @param devicePath The path to the I2C device, e.g. `/dev/i2c-1`.
+  ///   The string has to exist as long as this instance.
+  ///
+  explicit AS1130LinuxBus(const char *devicePath);
+
+  /// @brief Close the device.
+  ///
+  ~AS1130LinuxBus();
+
+  AS1130LinuxBus(const AS1130LinuxBus&) = delete;
+  AS1130LinuxBus& operator=(const AS1130LinuxBus&) = delete;
+
+public:
+  /// @brief Open the device.
+  ///
+  /// @return `true` on success, `false` if the device could not be opened.
+  ///   In this case, `errno` is set by the system.
+  ///
+  bool open();
+
+  /// @brief Close the device.
+  ///
+  void close();
+
+  /// @brief Check if the device is open.
+  ///
+  bool isOpen() const;
+
+  /// @brief Set the timeout for transfers.
+  ///
+  /// The kernel uses a resolution of 10 milliseconds. The timeout is applied
+  /// immediately if the device is open, and each time the device is opened.
+  ///
+  /// @param milliseconds The timeout in milliseconds, or zero for the default of the driver.
+  ///
+  void setTimeout(uint16_t milliseconds);
+
+public: // Implement AS1130Bus
+  bool transfer(uint8_t chipAddress, const Message *messages, uint8_t count) override;
+  uint16_t getMaximumDataLength() const override;
+  void delayMs(uint16_t milliseconds) override;
+  uint32_t getTimeUs() override;
+
+private:
+  const char *_devicePath; ///< The path to the I2C device.
+  int _fileDescriptor; ///< The file descriptor of the open device, or -1.
+  uint16_t _timeoutMs; ///< The timeout for transfers, or zero for the default.
+  std::vector<uint8_t> _writeBuffer; ///< The buffer for the combined write data.
+};
+
+
+}
+
@@ -0,0 +1,139 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130MemoryCache.h"
+
+
+#include "LRAS1130.h"
+
+#include <cstring>
+
+
+namespace lr {
+
+
+namespace {
+
+
+/// The number of on/off frames.
+///
+const uint8_t cFrameCount = 36;
+
+/// The number of bytes in one on/off frame.
+///
+const uint8_t cFrameSize = 0x18;
+
+/// The number of blink&PWM sets.
+///
+const uint8_t cBlinkAndPwmSetCount = 6;
+
+/// The number of bytes in one blink&PWM set.
+///
+const uint8_t cBlinkAndPwmSetSize = 0x9c;
+
+
+}
+
+
+const uint16_t AS1130MemoryCache::cCacheSize;
+
+
+AS1130MemoryCache::AS1130MemoryCache()
+{
+  std::memset(_data, 0, sizeof(_data));
+  invalidate();
+}
+
+
+void AS1130MemoryCache::invalidate()
+{
+  std::memset(_known, 0, sizeof(_known));
+}
+
+
+void AS1130MemoryCache::invalidate(uint8_t registerSelection)
+{
+  uint16_t bankIndex;
+  uint8_t bankSize;
+  if (!getBank(registerSelection, bankIndex, bankSize)) {
+    return;
+  }
+  for (uint16_t index = bankIndex; index < bankIndex + bankSize; ++index) {
+    _known[index>>3] &= ~(1<<(index&0x7));
+  }
+}
+
+
+bool AS1130MemoryCache::isCached(uint8_t registerSelection) const
+{
+  uint16_t bankIndex;
+  uint8_t bankSize;
+  return getBank(registerSelection, bankIndex, bankSize);
+}
+
+
+bool AS1130MemoryCache::isEqual(uint8_t registerSelection, uint8_t address, uint8_t value) const
+{
+  const int16_t index = getIndex(registerSelection, address);
+  if (index < 0) {
+    return false;
+  }
+  return (_known[index>>3] & (1<<(index&0x7))) != 0 && _data[index] == value;
+}
+
+
+void AS1130MemoryCache::update(uint8_t registerSelection, uint8_t address, uint8_t value)
+{
+  const int16_t index = getIndex(registerSelection, address);
+  if (index < 0) {
+    return;
+  }
+  _data[index] = value;
+  _known[index>>3] |= (1<<(index&0x7));
+}
+
+
+int16_t AS1130MemoryCache::getIndex(uint8_t registerSelection, uint8_t address) const
+{
+  uint16_t bankIndex;
+  uint8_t bankSize;
+  if (!getBank(registerSelection, bankIndex, bankSize) || address >= bankSize) {
+    return -1;
+  }
+  return static_cast<int16_t>(bankIndex + address);
+}
+
+
+bool AS1130MemoryCache::getBank(uint8_t registerSelection, uint16_t &bankIndex, uint8_t &bankSize) const
+{
+  if (registerSelection >= AS1130::RS_OnOffFrame && registerSelection < AS1130::RS_OnOffFrame + cFrameCount) {
+    bankIndex = (registerSelection - AS1130::RS_OnOffFrame) * cFrameSize;
+    bankSize = cFrameSize;
+    return true;
+  }
+  if (registerSelection >= AS1130::RS_BlinkAndPwmSet && registerSelection < AS1130::RS_BlinkAndPwmSet + cBlinkAndPwmSetCount) {
+    bankIndex = (cFrameCount * cFrameSize) + (registerSelection - AS1130::RS_BlinkAndPwmSet) * cBlinkAndPwmSetSize;
+    bankSize = cBlinkAndPwmSetSize;
+    return true;
+  }
+  return false;
+}
+
+
+}
+
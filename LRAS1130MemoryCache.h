@@ -0,0 +1,104 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include <cinttypes>
+
+
+namespace lr {
+
+
+/// @brief A copy of the on/off frames and blink&PWM sets written to the chip.
+///
+/// Assign an instance of this class to an AS1130 driver using AS1130::setMemoryCache().
+/// The driver then compares all writes to on/off frames and blink&PWM sets with the
+/// cached content and only sends the bytes which changed.
+///
+/// The cache only knows bytes which were written through the driver. It requires
+/// about 2kB of RAM.
+///
+class AS1130MemoryCache
+{
+public:
+  /// @brief Create a new empty cache.
+  ///
+  AS1130MemoryCache();
+
+public:
+  /// @brief Forget the content of all frames and sets.
+  ///
+  void invalidate();
+
+  /// @brief Forget the content of one frame or set.
+  ///
+  /// @param registerSelection The register selection of the frame or set.
+  ///
+  void invalidate(uint8_t registerSelection);
+
+  /// @brief Check if the given register selection is a cached frame or set.
+  ///
+  /// @param registerSelection The register selection.
+  /// @return `true` if writes to this register selection are cached.
+  ///
+  bool isCached(uint8_t registerSelection) const;
+
+  /// @brief Check if a byte is known to contain the given value.
+  ///
+  /// @param registerSelection The register selection of the frame or set.
+  /// @param address The address in the frame or set.
+  /// @param value The value to compare.
+  /// @return `true` if the cached byte is known and equal to the value.
+  ///
+  bool isEqual(uint8_t registerSelection, uint8_t address, uint8_t value) const;
+
+  /// @brief Store a byte written to the chip.
+  ///
+  /// @param registerSelection The register selection of the frame or set.
+  /// @param address The address in the frame or set.
+  /// @param value The written value.
+  ///
+  void update(uint8_t registerSelection, uint8_t address, uint8_t value);
+
+private:
+  /// @brief Get the index of a byte in the cache.
+  ///
+  /// @return The index, or -1 if the location is not cached.
+  ///
+  int16_t getIndex(uint8_t registerSelection, uint8_t address) const;
+
+  /// @brief Get the index of the first byte and the size of a frame or set.
+  ///
+  /// @return `true` if the register selection is cached.
+  ///
+  bool getBank(uint8_t registerSelection, uint16_t &bankIndex, uint8_t &bankSize) const;
+
+private:
+  /// @brief The number of cached bytes.
+  ///
+  static const uint16_t cCacheSize = (36 * 0x18) + (6 * 0x9c);
+
+private:
+  uint8_t _data[cCacheSize]; ///< The cached bytes, all frames followed by all sets.
+  uint8_t _known[(cCacheSize+7)/8]; ///< One bit for each cached byte, set if the byte is known.
+};
+
+
+}
+
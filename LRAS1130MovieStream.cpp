@@ -0,0 +1,170 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130MovieStream.h"
+
+
+namespace lr {
+
+
+AS1130MovieStream::AS1130MovieStream(AS1130 &driver, uint8_t firstFrameIndex, uint8_t frameCount)
+  : _driver(driver), _firstFrameIndex(firstFrameIndex), _frameCount(frameCount < 2 ? 2 : frameCount),
+    _playPosition(0), _writePosition(0), _queuedCount(0), _isPlaying(false), _isUnderrun(false),
+    _isInterruptFrameTrackingEnabled(false), _playedFrameCount(0)
+{
+}
+
+
+void AS1130MovieStream::start()
+{
+  if (_isPlaying) {
+    return;
+  }
+  // The queue always starts at the first frame, see stop().
+  _playPosition = 0;
+  _playedFrameCount = 0;
+  _isUnderrun = false;
+  _driver.setMovieFrameCount(_frameCount);
+  _driver.setMovieLoopCount(AS1130::MovieLoopEndless);
+  _driver.startMovie(_firstFrameIndex);
+  _isPlaying = true;
+}
+
+
+void AS1130MovieStream::stop()
+{
+  _driver.stopMovie();
+  _isPlaying = false;
+  // The movie restarts at the first frame, so the queue has to start there as well.
+  _playPosition = 0;
+  _writePosition = 0;
+  _queuedCount = 0;
+}
+
+
+void AS1130MovieStream::update()
+{
+  if (!_isPlaying) {
+    return;
+  }
+  const uint8_t displayedFrame = _driver.getDisplayedFrame();
+  if (displayedFrame < _firstFrameIndex || displayedFrame >= _firstFrameIndex + _frameCount) {
+    return;
+  }
+  const uint8_t position = displayedFrame - _firstFrameIndex;
+  const uint8_t playedCount = (position + _frameCount - _playPosition) % _frameCount;
+  if (playedCount == 0) {
+    return;
+  }
+  _playedFrameCount += playedCount;
+  _playPosition = position;
+  if (playedCount >= _queuedCount) {
+    // The chip displays a frame which was already played. Continue
+    // writing after the displayed frame.
+    _isUnderrun = true;
+    _queuedCount = 1;
+    _writePosition = (position + 1) % _frameCount;
+  } else {
+    _queuedCount -= playedCount;
+  }
+}
+
+
+uint8_t AS1130MovieStream::getFreeFrameCount() const
+{
+  return _frameCount - _queuedCount;
+}
+
+
+bool AS1130MovieStream::pushFrame24x5(const uint8_t *data, uint8_t pwmSetIndex)
+{
+  const int8_t frameIndex = prepareNextFrame();
+  if (frameIndex < 0) {
+    return false;
+  }
+  _driver.setOnOffFrame24x5(static_cast<uint8_t>(frameIndex), data, pwmSetIndex);
+  finishPush();
+  return true;
+}
+
+
+bool AS1130MovieStream::pushFrame12x11(const uint8_t *data, uint8_t pwmSetIndex)
+{
+  const int8_t frameIndex = prepareNextFrame();
+  if (frameIndex < 0) {
+    return false;
+  }
+  _driver.setOnOffFrame12x11(static_cast<uint8_t>(frameIndex), data, pwmSetIndex);
+  finishPush();
+  return true;
+}
+
+
+bool AS1130MovieStream::pushFrame(const AS1130Frame &frame)
+{
+  const int8_t frameIndex = prepareNextFrame();
+  if (frameIndex < 0) {
+    return false;
+  }
+  _driver.setOnOffFrame(static_cast<uint8_t>(frameIndex), frame);
+  finishPush();
+  return true;
+}
+
+
+void AS1130MovieStream::setInterruptFrameTrackingEnabled(bool enabled)
+{
+  _isInterruptFrameTrackingEnabled = enabled;
+}
+
+
+bool AS1130MovieStream::checkUnderrun()
+{
+  const bool result = _isUnderrun;
+  _isUnderrun = false;
+  return result;
+}
+
+
+uint32_t AS1130MovieStream::getPlayedFrameCount() const
+{
+  return _playedFrameCount;
+}
+
+
+int8_t AS1130MovieStream::prepareNextFrame()
+{
+  if (_queuedCount >= _frameCount) {
+    return -1;
+  }
+  return static_cast<int8_t>(_firstFrameIndex + _writePosition);
+}
+
+
+void AS1130MovieStream::finishPush()
+{
+  if (_isInterruptFrameTrackingEnabled) {
+    _driver.setInterruptFrame(_firstFrameIndex + _writePosition);
+  }
+  _writePosition = (_writePosition + 1) % _frameCount;
+  ++_queuedCount;
+}
+
+
+}
+
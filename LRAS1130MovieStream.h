@@ -0,0 +1,163 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+
+namespace lr {
+
+
+/// @brief Play movies longer than the frame memory of the chip.
+///
+/// This class uses a range of on/off frames as ring buffer for an endless
+/// movie. It tracks the frame displayed by the chip and reuses frames which were
+/// already played for new frames. This way, a movie of any length can be played
+/// by the chip with the frame timing of the chip.
+///
+/// Call update() regularly, at least once for each pass of the chip through the
+/// ring buffer, and push new frames as soon as there are free frames.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130MovieStream stream(ledDriver, 0, 8);
+/// while (stream.getFreeFrameCount() > 0) {
+///   stream.pushFrame24x5(nextBitmap());
+/// }
+/// stream.start();
+/// ledDriver.startChip();
+///
+/// void loop() {
+///   stream.update();
+///   while (stream.getFreeFrameCount() > 0) {
+///     stream.pushFrame24x5(nextBitmap());
+///   }
+/// }
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130MovieStream
+{
+public:
+  /// @brief Create a new movie stream.
+  ///
+  /// This does not access the chip.
+  ///
+  /// @param driver The driver for the chip.
+  /// @param firstFrameIndex The index of the first frame of the ring buffer.
+  /// @param frameCount The number of frames in the ring buffer, between 2 and 36.
+  ///
+  AS1130MovieStream(AS1130 &driver, uint8_t firstFrameIndex, uint8_t frameCount);
+
+public:
+  /// @brief Start playing the movie.
+  ///
+  /// This sets the movie frame count and an endless loop, and starts the movie
+  /// at the first frame of the ring buffer. Push frames before calling this function.
+  /// If the movie is already playing, this function does nothing.
+  ///
+  void start();
+
+  /// @brief Stop playing the movie.
+  ///
+  /// This discards all pushed frames. Push new frames before calling start() again.
+  ///
+  void stop();
+
+  /// @brief Update the playback position.
+  ///
+  /// This reads the displayed frame from the chip and frees all frames which
+  /// were played since the last call.
+  ///
+  void update();
+
+  /// @brief Get the number of frames which can be pushed.
+  ///
+  uint8_t getFreeFrameCount() const;
+
+  /// @brief Push a new frame from a 24x5 bitmap.
+  ///
+  /// @param data An array with 15 bytes, see AS1130::setOnOffFrame24x5().
+  /// @param pwmSetIndex The PWM set index for the frame.
+  /// @return `true` on success, `false` if there is no free frame.
+  ///
+  bool pushFrame24x5(const uint8_t *data, uint8_t pwmSetIndex = 0);
+
+  /// @brief Push a new frame from a 12x11 bitmap.
+  ///
+  /// @param data An array with 22 bytes, see AS1130::setOnOffFrame12x11().
+  /// @param pwmSetIndex The PWM set index for the frame.
+  /// @return `true` on success, `false` if there is no free frame.
+  ///
+  bool pushFrame12x11(const uint8_t *data, uint8_t pwmSetIndex = 0);
+
+  /// @brief Push a new frame from already converted frame data.
+  ///
+  /// @param frame The frame to push.
+  /// @return `true` on success, `false` if there is no free frame.
+  ///
+  bool pushFrame(const AS1130Frame &frame);
+
+  /// @brief Enable the interrupt frame tracking.
+  ///
+  /// If enabled, the interrupt frame of the chip is set to the last pushed frame.
+  /// Enable the IMF_SelectedPicture flag in the interrupt mask to get an
+  /// interrupt when the chip reaches the last pushed frame.
+  ///
+  /// @param enabled True to enable the tracking, false to disable it.
+  ///
+  void setInterruptFrameTrackingEnabled(bool enabled);
+
+  /// @brief Check if the chip played frames which were not pushed in time.
+  ///
+  /// The flag is cleared by this call.
+  ///
+  /// @return `true` if an underrun happened since the last call.
+  ///
+  bool checkUnderrun();
+
+  /// @brief Get the number of frames played since the start.
+  ///
+  uint32_t getPlayedFrameCount() const;
+
+private:
+  /// @brief Get the next frame to write, or -1 if there is no free frame.
+  ///
+  int8_t prepareNextFrame();
+
+  /// @brief Finish pushing a frame.
+  ///
+  void finishPush();
+
+private:
+  AS1130 &_driver; ///< The driver for the chip.
+  uint8_t _firstFrameIndex; ///< The first frame of the ring buffer.
+  uint8_t _frameCount; ///< The number of frames in the ring buffer.
+  uint8_t _playPosition; ///< The position of the displayed frame in the ring buffer.
+  uint8_t _writePosition; ///< The position for the next pushed frame.
+  uint8_t _queuedCount; ///< The number of pushed frames which are not played, including the displayed one.
+  bool _isPlaying; ///< If the movie was started.
+  bool _isUnderrun; ///< If an underrun happened.
+  bool _isInterruptFrameTrackingEnabled; ///< If the interrupt frame is set to the last pushed frame.
+  uint32_t _playedFrameCount; ///< The number of played frames.
+};
+
+
+}
+
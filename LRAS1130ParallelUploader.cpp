@@ -0,0 +1,222 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#if defined(__linux__) && !defined(ARDUINO)
+
+
+#include "LRAS1130ParallelUploader.h"
+
+#include <cstring>
+
+
+namespace lr {
+
+
+namespace {
+const uint16_t cQueueSize = 64; ///< The number of jobs in the queue of a worker.
+const uint8_t cMaximumJobDataLength = 0x9c; ///< The size of a blink&PWM set.
+const uint8_t cFrameSize = 0x18; ///< The size of an on/off frame.
+const uint8_t cPwmValueOffset = 0x18; ///< The address of the first PWM value in a set.
+const uint8_t cPwmValueCount = 0x84; ///< The number of PWM values in a set.
+}
+
+
+/// @brief A single upload, or the end of a batch.
+///
+struct AS1130ParallelUploader::Job {
+  AS1130 *driver; ///< The driver for the chip, or `nullptr` for the end of a batch.
+  uint32_t batch; ///< The number of the batch, for the end of a batch.
+  uint8_t registerSelection; ///< The register selection address.
+  uint8_t startAddress; ///< The address of the first register.
+  uint8_t length; ///< The number of bytes.
+  uint8_t data[cMaximumJobDataLength]; ///< The data to write.
+};
+
+
+/// @brief The worker thread and queue for one bus.
+///
+/// The queue has a single producer and a single consumer. The producer only
+/// writes `tail`, the consumer only writes `head`.
+///
+struct AS1130ParallelUploader::Worker {
+  AS1130Bus *bus; ///< The bus of this worker.
+  Job jobs[cQueueSize]; ///< The ring buffer with the jobs.
+  std::atomic<uint16_t> head; ///< The index of the next job to process.
+  std::atomic<uint16_t> tail; ///< The index for the next submitted job.
+  std::atomic<uint32_t> completedBatch; ///< The last batch finished by this worker.
+  std::atomic<bool> isStopping; ///< Set to stop the worker after the submitted jobs.
+  std::mutex mutex; ///< The mutex for the wake-up signal, not used for the queue.
+  std::condition_variable wakeUp; ///< Signalled if a job was submitted.
+  std::thread thread; ///< The worker thread.
+};
+
+
+AS1130ParallelUploader::AS1130ParallelUploader()
+  : _batch(0)
+{
+}
+
+
+AS1130ParallelUploader::~AS1130ParallelUploader()
+{
+  for (auto &worker : _workers) {
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->isStopping.store(true);
+    }
+    worker->wakeUp.notify_one();
+    worker->thread.join();
+  }
+}
+
+
+void AS1130ParallelUploader::submitFrame(AS1130 &driver, uint8_t frameIndex, const AS1130Frame &frame)
+{
+  submitMemoryBlock(driver, AS1130::RS_OnOffFrame + frameIndex, 0, frame.data, cFrameSize);
+}
+
+
+void AS1130ParallelUploader::submitPwmValues(AS1130 &driver, uint8_t setIndex, const uint8_t *values)
+{
+  submitMemoryBlock(driver, AS1130::RS_BlinkAndPwmSet + setIndex, cPwmValueOffset, values, cPwmValueCount);
+}
+
+
+void AS1130ParallelUploader::submitMemoryBlock(AS1130 &driver, uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint8_t length)
+{
+  Job job;
+  job.driver = &driver;
+  job.batch = 0;
+  job.registerSelection = registerSelection;
+  job.startAddress = startAddress;
+  job.length = (length > cMaximumJobDataLength ? cMaximumJobDataLength : length);
+  std::memcpy(job.data, data, job.length);
+  push(getWorker(driver.getBus()), job);
+}
+
+
+uint32_t AS1130ParallelUploader::commit()
+{
+  ++_batch;
+  Job job;
+  job.driver = nullptr;
+  job.batch = _batch;
+  job.length = 0;
+  for (auto &worker : _workers) {
+    push(*worker, job);
+  }
+  return _batch;
+}
+
+
+bool AS1130ParallelUploader::isBatchComplete(uint32_t batch) const
+{
+  for (const auto &worker : _workers) {
+    if (worker->completedBatch.load(std::memory_order_acquire) < batch) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void AS1130ParallelUploader::waitForBatch(uint32_t batch)
+{
+  std::unique_lock<std::mutex> lock(_completionMutex);
+  _completion.wait(lock, [this, batch]() { return isBatchComplete(batch); });
+}
+
+
+uint8_t AS1130ParallelUploader::getBusCount() const
+{
+  return static_cast<uint8_t>(_workers.size());
+}
+
+
+AS1130ParallelUploader::Worker& AS1130ParallelUploader::getWorker(AS1130Bus &bus)
+{
+  for (auto &worker : _workers) {
+    if (worker->bus == &bus) {
+      return *worker;
+    }
+  }
+  std::unique_ptr<Worker> worker(new Worker());
+  worker->bus = &bus;
+  worker->head.store(0);
+  worker->tail.store(0);
+  // A new worker has no jobs of earlier batches.
+  worker->completedBatch.store(_batch);
+  worker->isStopping.store(false);
+  Worker &result = *worker;
+  result.thread = std::thread(&AS1130ParallelUploader::run, this, std::ref(result));
+  _workers.push_back(std::move(worker));
+  return result;
+}
+
+
+void AS1130ParallelUploader::push(Worker &worker, const Job &job)
+{
+  const uint16_t tail = worker.tail.load(std::memory_order_relaxed);
+  const uint16_t nextTail = (tail + 1) % cQueueSize;
+  while (nextTail == worker.head.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+  worker.jobs[tail] = job;
+  worker.tail.store(nextTail, std::memory_order_release);
+  {
+    // Lock the mutex, so the wake-up can not get lost between the check and the wait of the worker.
+    std::lock_guard<std::mutex> lock(worker.mutex);
+  }
+  worker.wakeUp.notify_one();
+}
+
+
+void AS1130ParallelUploader::run(Worker &worker)
+{
+  for (;;) {
+    const uint16_t head = worker.head.load(std::memory_order_relaxed);
+    if (head == worker.tail.load(std::memory_order_acquire)) {
+      std::unique_lock<std::mutex> lock(worker.mutex);
+      worker.wakeUp.wait(lock, [&worker, head]() {
+        return worker.isStopping.load() || head != worker.tail.load(std::memory_order_acquire);
+      });
+      if (head == worker.tail.load(std::memory_order_acquire)) {
+        return;
+      }
+      continue;
+    }
+    const Job &job = worker.jobs[head];
+    if (job.driver != nullptr) {
+      job.driver->writeMemoryBlock(job.registerSelection, job.startAddress, job.data, job.length);
+    } else {
+      {
+        std::lock_guard<std::mutex> lock(_completionMutex);
+        worker.completedBatch.store(job.batch, std::memory_order_release);
+      }
+      _completion.notify_all();
+    }
+    worker.head.store((head + 1) % cQueueSize, std::memory_order_release);
+  }
+}
+
+
+}
+
+
+#endif
+
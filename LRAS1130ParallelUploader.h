@@ -0,0 +1,158 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace lr {
+
+
+/// @brief Upload data to chips on multiple buses at the same time.
+///
+/// This class is only available on Linux. It runs one worker thread for each
+/// bus. Uploads are submitted into a lock-free queue of the worker for the bus
+/// of the chip, so uploads for chips on different buses run in parallel.
+///
+/// A batch groups all uploads submitted since the last batch. Wait for the
+/// batch to complete before displaying the uploaded frames, for example with
+/// AS1130Array::startPicture().
+///
+/// All functions have to be called from the same thread. While a batch is not
+/// complete, the drivers of the chips must not be used by other code.
+/// Link with `-pthread`.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130ParallelUploader uploader;
+/// for (uint8_t i = 0; i < display.getChipCount(); ++i) {
+///   lr::AS1130Frame frame;
+///   display.getTileFrame(i, frame);
+///   uploader.submitFrame(display.getChip(i), hiddenFrameIndex, frame);
+/// }
+/// uploader.waitForBatch(uploader.commit());
+/// display.startPicture(hiddenFrameIndex);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130ParallelUploader
+{
+public:
+  /// @brief Create a new uploader without workers.
+  ///
+  /// The worker for a bus is started with the first upload for a chip on the bus.
+  ///
+  AS1130ParallelUploader();
+
+  /// @brief Finish all submitted uploads and stop the workers.
+  ///
+  ~AS1130ParallelUploader();
+
+  AS1130ParallelUploader(const AS1130ParallelUploader&) = delete;
+  AS1130ParallelUploader& operator=(const AS1130ParallelUploader&) = delete;
+
+public:
+  /// @brief Submit an on/off frame.
+  ///
+  /// If the queue of the bus is full, this call waits for free space.
+  ///
+  /// @param driver The driver for the chip.
+  /// @param frameIndex The index of the frame.
+  /// @param frame The frame data.
+  ///
+  void submitFrame(AS1130 &driver, uint8_t frameIndex, const AS1130Frame &frame);
+
+  /// @brief Submit the PWM values of a blink&PWM set.
+  ///
+  /// If the queue of the bus is full, this call waits for free space.
+  ///
+  /// @param driver The driver for the chip.
+  /// @param setIndex The index of the set.
+  /// @param values An array with 132 PWM values, see AS1130::setPwmValues().
+  ///
+  void submitPwmValues(AS1130 &driver, uint8_t setIndex, const uint8_t *values);
+
+  /// @brief Submit a block of memory.
+  ///
+  /// If the queue of the bus is full, this call waits for free space.
+  ///
+  /// @param driver The driver for the chip.
+  /// @param registerSelection The register selection address.
+  /// @param startAddress The address of the first register.
+  /// @param data The data to write.
+  /// @param length The number of bytes, at most 156.
+  ///
+  void submitMemoryBlock(AS1130 &driver, uint8_t registerSelection, uint8_t startAddress, const uint8_t *data, uint8_t length);
+
+  /// @brief Close the current batch.
+  ///
+  /// @return The number of the batch, for isBatchComplete() and waitForBatch().
+  ///
+  uint32_t commit();
+
+  /// @brief Check if all buses finished a batch.
+  ///
+  /// @param batch The number of the batch.
+  ///
+  bool isBatchComplete(uint32_t batch) const;
+
+  /// @brief Wait until all buses finished a batch.
+  ///
+  /// @param batch The number of the batch.
+  ///
+  void waitForBatch(uint32_t batch);
+
+  /// @brief Get the number of buses with a worker.
+  ///
+  uint8_t getBusCount() const;
+
+private:
+  struct Job;
+  struct Worker;
+
+private:
+  /// @brief Get the worker for a bus, start a new one if required.
+  ///
+  Worker& getWorker(AS1130Bus &bus);
+
+  /// @brief Add a job to the queue of a worker.
+  ///
+  void push(Worker &worker, const Job &job);
+
+  /// @brief The main loop of a worker.
+  ///
+  void run(Worker &worker);
+
+private:
+  std::vector<std::unique_ptr<Worker>> _workers; ///< The workers, one for each bus.
+  uint32_t _batch; ///< The number of the current batch.
+  std::mutex _completionMutex; ///< The mutex for the completion signal.
+  std::condition_variable _completion; ///< Signalled if a worker finished a batch.
+};
+
+
+}
+
@@ -0,0 +1,125 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130PictureCache.h"
+
+
+#include <cstring>
+
+
+namespace lr {
+
+
+AS1130PictureCache::AS1130PictureCache(AS1130 &driver, uint8_t firstFrameIndex, Slot *slots, uint8_t frameCount)
+  : _driver(driver), _firstFrameIndex(firstFrameIndex),
+    _frameCount(frameCount > cMaximumFrameCount ? cMaximumFrameCount : frameCount),
+    _displayedSlot(0), _blinkAll(false), _useCounter(0), _slots(slots)
+{
+  invalidate();
+}
+
+
+bool AS1130PictureCache::show24x5(const uint8_t *data, uint8_t pwmSetIndex)
+{
+  AS1130Frame frame;
+  AS1130::encodeFrame24x5(data, frame.data, pwmSetIndex);
+  return show(frame);
+}
+
+
+bool AS1130PictureCache::show12x11(const uint8_t *data, uint8_t pwmSetIndex)
+{
+  AS1130Frame frame;
+  AS1130::encodeFrame12x11(data, frame.data, pwmSetIndex);
+  return show(frame);
+}
+
+
+bool AS1130PictureCache::show(const AS1130Frame &frame)
+{
+  for (uint8_t slot = 0; slot < _frameCount; ++slot) {
+    if (_slots[slot].lastUse != 0 && std::memcmp(_slots[slot].frame.data, frame.data, sizeof(frame.data)) == 0) {
+      display(slot);
+      return true;
+    }
+  }
+  const uint8_t slot = getLeastRecentlyUsedSlot();
+  _driver.setOnOffFrame(_firstFrameIndex + slot, frame);
+  _slots[slot].frame = frame;
+  display(slot);
+  return false;
+}
+
+
+void AS1130PictureCache::setBlinkAll(bool blinkAll)
+{
+  _blinkAll = blinkAll;
+}
+
+
+void AS1130PictureCache::invalidate()
+{
+  _useCounter = 0;
+  for (uint8_t slot = 0; slot < _frameCount; ++slot) {
+    _slots[slot].lastUse = 0;
+  }
+}
+
+
+uint8_t AS1130PictureCache::getDisplayedFrameIndex() const
+{
+  return _firstFrameIndex + _displayedSlot;
+}
+
+
+uint8_t AS1130PictureCache::getLeastRecentlyUsedSlot() const
+{
+  // The displayed slot is always the most recently used one, so it is
+  // never replaced while it is visible.
+  uint8_t result = 0;
+  for (uint8_t slot = 0; slot < _frameCount; ++slot) {
+    if (_slots[slot].lastUse == 0) {
+      return slot;
+    }
+    if (_slots[slot].lastUse < _slots[result].lastUse) {
+      result = slot;
+    }
+  }
+  return result;
+}
+
+
+void AS1130PictureCache::display(uint8_t slot)
+{
+  if (_useCounter == 0xffff) {
+    // Keep the order of the slots, but make room for new counter values.
+    for (uint8_t i = 0; i < _frameCount; ++i) {
+      if (_slots[i].lastUse != 0) {
+        _slots[i].lastUse = (_slots[i].lastUse >> 1) | 1;
+      }
+    }
+    _useCounter >>= 1;
+  }
+  _slots[slot].lastUse = ++_useCounter;
+  _displayedSlot = slot;
+  _driver.startPicture(getDisplayedFrameIndex(), _blinkAll);
+}
+
+
+}
+
@@ -0,0 +1,143 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+
+namespace lr {
+
+
+/// @brief A cache for recurring pictures in the frame memory of the chip.
+///
+/// This class keeps a number of on/off frames of the chip as cache for
+/// pictures. The cache keeps a copy of the content of each frame in a slot.
+/// If a picture is already in one of the frames, it is displayed with a single
+/// write to the picture register. Otherwise, the least recently used frame is
+/// replaced with the new picture.
+///
+/// The slots are provided by the caller, one slot of 26 bytes for each frame
+/// used by the cache.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130PictureCache::Slot iconSlots[8];
+/// lr::AS1130PictureCache icons(ledDriver, 0, iconSlots, 8);
+/// icons.show24x5(wifiIcon);
+/// ledDriver.startChip();
+/// // ...
+/// icons.show24x5(batteryIcon);
+/// icons.show24x5(wifiIcon); // Only writes the picture register.
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130PictureCache
+{
+public:
+  /// @brief The maximum number of frames in the cache.
+  ///
+  static const uint8_t cMaximumFrameCount = 36;
+
+  /// @brief The state of one frame of the cache.
+  ///
+  struct Slot {
+    AS1130Frame frame; ///< The content of the frame.
+    uint16_t lastUse; ///< The last use of the frame, zero if the frame is empty.
+  };
+
+public:
+  /// @brief Create a new picture cache.
+  ///
+  /// This does not access the chip.
+  ///
+  /// @param driver The driver for the chip.
+  /// @param firstFrameIndex The index of the first frame used for the cache.
+  /// @param slots An array with one slot for each frame. The array has to
+  ///   exist as long as this object.
+  /// @param frameCount The number of consecutive frames used, between 2 and 36.
+  ///   This is the number of elements in `slots`.
+  ///
+  AS1130PictureCache(AS1130 &driver, uint8_t firstFrameIndex, Slot *slots, uint8_t frameCount);
+
+public:
+  /// @brief Show a picture from a 24x5 bitmap.
+  ///
+  /// @param data An array with 15 bytes, see AS1130::setOnOffFrame24x5().
+  /// @param pwmSetIndex The PWM set index for the picture.
+  /// @return `true` if the picture was found in the cache.
+  ///
+  bool show24x5(const uint8_t *data, uint8_t pwmSetIndex = 0);
+
+  /// @brief Show a picture from a 12x11 bitmap.
+  ///
+  /// @param data An array with 22 bytes, see AS1130::setOnOffFrame12x11().
+  /// @param pwmSetIndex The PWM set index for the picture.
+  /// @return `true` if the picture was found in the cache.
+  ///
+  bool show12x11(const uint8_t *data, uint8_t pwmSetIndex = 0);
+
+  /// @brief Show a picture from already converted frame data.
+  ///
+  /// @param frame The frame to show.
+  /// @return `true` if the picture was found in the cache.
+  ///
+  bool show(const AS1130Frame &frame);
+
+  /// @brief Set if all LEDs of the picture blink.
+  ///
+  /// The setting is used for the next call of one of the show functions.
+  ///
+  /// @param blinkAll True if all LEDs should blink.
+  ///
+  void setBlinkAll(bool blinkAll);
+
+  /// @brief Forget all cached pictures.
+  ///
+  /// Call this after the frames were changed by other code, or after a reset of the chip.
+  ///
+  void invalidate();
+
+  /// @brief Get the index of the displayed frame.
+  ///
+  /// @return The frame index, or the first frame index if no picture was shown yet.
+  ///
+  uint8_t getDisplayedFrameIndex() const;
+
+private:
+  /// @brief Get the slot to replace with a new picture.
+  ///
+  uint8_t getLeastRecentlyUsedSlot() const;
+
+  /// @brief Mark a slot as used and display it.
+  ///
+  void display(uint8_t slot);
+
+private:
+  AS1130 &_driver; ///< The driver for the chip.
+  uint8_t _firstFrameIndex; ///< The first frame used for the cache.
+  uint8_t _frameCount; ///< The number of frames used for the cache.
+  uint8_t _displayedSlot; ///< The slot of the displayed frame.
+  bool _blinkAll; ///< If all LEDs of the picture blink.
+  uint16_t _useCounter; ///< The counter for the last use of the slots.
+  Slot *_slots; ///< The content and last use of each frame.
+};
+
+
+}
+
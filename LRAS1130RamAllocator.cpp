@@ -0,0 +1,245 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130RamAllocator.h"
+
+
+namespace lr {
+
+
+namespace {
+const uint8_t cMaximumFrameCount = 36; ///< The number of frames with RAM configuration 1.
+const uint8_t cFramesPerPwmSet = 6; ///< The number of frames which use the memory of one blink&PWM set.
+}
+
+
+AS1130RamAllocator::AS1130RamAllocator(AS1130::RamConfiguration ramConfiguration, bool isDotCorrectionUsed)
+{
+  reset(ramConfiguration, isDotCorrectionUsed);
+}
+
+
+void AS1130RamAllocator::reset(AS1130::RamConfiguration ramConfiguration, bool isDotCorrectionUsed)
+{
+  _ramConfiguration = ramConfiguration;
+  _frameCount = getFrameCount(ramConfiguration, isDotCorrectionUsed);
+  for (uint8_t i = 0; i < sizeof(_frameUsage); ++i) {
+    _frameUsage[i] = 0;
+  }
+  _pwmSetUsage = 0;
+}
+
+
+AS1130::RamConfiguration AS1130RamAllocator::getRamConfiguration() const
+{
+  return _ramConfiguration;
+}
+
+
+int8_t AS1130RamAllocator::allocateFrames(uint8_t count)
+{
+  if (count == 0) {
+    return -1;
+  }
+  const int8_t firstFrameIndex = findFreeRange(count);
+  if (firstFrameIndex >= 0) {
+    markFrames(static_cast<uint8_t>(firstFrameIndex), count, true);
+  }
+  return firstFrameIndex;
+}
+
+
+int8_t AS1130RamAllocator::allocateFrame()
+{
+  return allocateFrames(1);
+}
+
+
+void AS1130RamAllocator::freeFrames(uint8_t firstFrameIndex, uint8_t count)
+{
+  markFrames(firstFrameIndex, count, false);
+}
+
+
+void AS1130RamAllocator::freeFrame(uint8_t frameIndex)
+{
+  markFrames(frameIndex, 1, false);
+}
+
+
+int8_t AS1130RamAllocator::allocatePwmSet()
+{
+  const uint8_t setCount = getPwmSetCount();
+  for (uint8_t setIndex = 0; setIndex < setCount; ++setIndex) {
+    if ((_pwmSetUsage & (1 << setIndex)) == 0) {
+      _pwmSetUsage |= (1 << setIndex);
+      return static_cast<int8_t>(setIndex);
+    }
+  }
+  return -1;
+}
+
+
+void AS1130RamAllocator::freePwmSet(uint8_t setIndex)
+{
+  if (setIndex < getPwmSetCount()) {
+    _pwmSetUsage &= ~(1 << setIndex);
+  }
+}
+
+
+bool AS1130RamAllocator::isFrameAllocated(uint8_t frameIndex) const
+{
+  if (frameIndex >= _frameCount) {
+    return true;
+  }
+  return (_frameUsage[frameIndex >> 3] & (1 << (frameIndex & 0x07))) != 0;
+}
+
+
+bool AS1130RamAllocator::isPwmSetAllocated(uint8_t setIndex) const
+{
+  if (setIndex >= getPwmSetCount()) {
+    return true;
+  }
+  return (_pwmSetUsage & (1 << setIndex)) != 0;
+}
+
+
+uint8_t AS1130RamAllocator::getFrameCount() const
+{
+  return _frameCount;
+}
+
+
+uint8_t AS1130RamAllocator::getFreeFrameCount() const
+{
+  uint8_t result = 0;
+  for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+    if (!isFrameAllocated(frameIndex)) {
+      ++result;
+    }
+  }
+  return result;
+}
+
+
+uint8_t AS1130RamAllocator::getLargestFreeFrameRange() const
+{
+  uint8_t result = 0;
+  uint8_t rangeSize = 0;
+  for (uint8_t frameIndex = 0; frameIndex < _frameCount; ++frameIndex) {
+    if (isFrameAllocated(frameIndex)) {
+      rangeSize = 0;
+    } else {
+      ++rangeSize;
+      if (rangeSize > result) {
+        result = rangeSize;
+      }
+    }
+  }
+  return result;
+}
+
+
+uint8_t AS1130RamAllocator::getFragmentation() const
+{
+  const uint8_t freeCount = getFreeFrameCount();
+  if (freeCount == 0) {
+    return 0;
+  }
+  return static_cast<uint8_t>(100 - (static_cast<uint16_t>(getLargestFreeFrameRange()) * 100 / freeCount));
+}
+
+
+uint8_t AS1130RamAllocator::getPwmSetCount() const
+{
+  return getPwmSetCount(_ramConfiguration);
+}
+
+
+uint8_t AS1130RamAllocator::getFreePwmSetCount() const
+{
+  uint8_t result = 0;
+  const uint8_t setCount = getPwmSetCount();
+  for (uint8_t setIndex = 0; setIndex < setCount; ++setIndex) {
+    if ((_pwmSetUsage & (1 << setIndex)) == 0) {
+      ++result;
+    }
+  }
+  return result;
+}
+
+
+uint8_t AS1130RamAllocator::getFrameCount(AS1130::RamConfiguration ramConfiguration, bool isDotCorrectionUsed)
+{
+  const uint8_t frameCount = cMaximumFrameCount - (getPwmSetCount(ramConfiguration) - 1) * cFramesPerPwmSet;
+  return isDotCorrectionUsed ? frameCount - 1 : frameCount;
+}
+
+
+uint8_t AS1130RamAllocator::getPwmSetCount(AS1130::RamConfiguration ramConfiguration)
+{
+  if (ramConfiguration < AS1130::RamConfiguration1) {
+    return 1;
+  }
+  if (ramConfiguration > AS1130::RamConfiguration6) {
+    return 6;
+  }
+  return static_cast<uint8_t>(ramConfiguration);
+}
+
+
+int8_t AS1130RamAllocator::findFreeRange(uint8_t count) const
+{
+  int8_t result = -1;
+  uint8_t resultSize = 0xff;
+  uint8_t rangeStart = 0;
+  uint8_t rangeSize = 0;
+  for (uint8_t frameIndex = 0; frameIndex <= _frameCount; ++frameIndex) {
+    if (frameIndex < _frameCount && !isFrameAllocated(frameIndex)) {
+      if (rangeSize == 0) {
+        rangeStart = frameIndex;
+      }
+      ++rangeSize;
+    } else {
+      if (rangeSize >= count && rangeSize < resultSize) {
+        result = static_cast<int8_t>(rangeStart);
+        resultSize = rangeSize;
+      }
+      rangeSize = 0;
+    }
+  }
+  return result;
+}
+
+
+void AS1130RamAllocator::markFrames(uint8_t firstFrameIndex, uint8_t count, bool allocated)
+{
+  for (uint8_t frameIndex = firstFrameIndex; frameIndex < _frameCount && frameIndex - firstFrameIndex < count; ++frameIndex) {
+    if (allocated) {
+      _frameUsage[frameIndex >> 3] |= (1 << (frameIndex & 0x07));
+    } else {
+      _frameUsage[frameIndex >> 3] &= ~(1 << (frameIndex & 0x07));
+    }
+  }
+}
+
+
+}
+
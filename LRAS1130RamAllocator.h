@@ -0,0 +1,177 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+
+
+namespace lr {
+
+
+/// @brief Bookkeeping for the on/off frames and blink&PWM sets of the chip.
+///
+/// This class keeps track of the frames and sets in use for a given RAM
+/// configuration. It hands out contiguous frame ranges for movies, single
+/// frames for pictures and single blink&PWM sets. It does not access the chip.
+///
+/// Frames are allocated using the smallest free range which fits, which keeps
+/// large ranges available for movies.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130RamAllocator ram(lr::AS1130::RamConfiguration2);
+/// const int8_t movieStart = ram.allocateFrames(12);
+/// const int8_t iconFrame = ram.allocateFrame();
+/// const int8_t pwmSet = ram.allocatePwmSet();
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130RamAllocator
+{
+public:
+  /// @brief Create a new allocator with all frames and sets free.
+  ///
+  /// @param ramConfiguration The RAM configuration of the chip.
+  /// @param isDotCorrectionUsed If the dot correction is used, which reserves the last frame.
+  ///
+  explicit AS1130RamAllocator(AS1130::RamConfiguration ramConfiguration = AS1130::RamConfiguration1,
+    bool isDotCorrectionUsed = false);
+
+public:
+  /// @brief Free all frames and sets and change the configuration.
+  ///
+  /// @param ramConfiguration The RAM configuration of the chip.
+  /// @param isDotCorrectionUsed If the dot correction is used, which reserves the last frame.
+  ///
+  void reset(AS1130::RamConfiguration ramConfiguration, bool isDotCorrectionUsed = false);
+
+  /// @brief Get the RAM configuration.
+  ///
+  AS1130::RamConfiguration getRamConfiguration() const;
+
+  /// @brief Allocate a contiguous range of frames.
+  ///
+  /// @param count The number of frames.
+  /// @return The index of the first frame, or -1 if there is no free range of this size.
+  ///
+  int8_t allocateFrames(uint8_t count);
+
+  /// @brief Allocate a single frame.
+  ///
+  /// @return The index of the frame, or -1 if there is no free frame.
+  ///
+  int8_t allocateFrame();
+
+  /// @brief Free a range of frames.
+  ///
+  /// @param firstFrameIndex The index of the first frame.
+  /// @param count The number of frames.
+  ///
+  void freeFrames(uint8_t firstFrameIndex, uint8_t count);
+
+  /// @brief Free a single frame.
+  ///
+  /// @param frameIndex The index of the frame.
+  ///
+  void freeFrame(uint8_t frameIndex);
+
+  /// @brief Allocate a blink&PWM set.
+  ///
+  /// @return The index of the set, or -1 if there is no free set.
+  ///
+  int8_t allocatePwmSet();
+
+  /// @brief Free a blink&PWM set.
+  ///
+  /// @param setIndex The index of the set.
+  ///
+  void freePwmSet(uint8_t setIndex);
+
+  /// @brief Check if a frame is allocated.
+  ///
+  /// Frames outside of the RAM configuration are reported as allocated.
+  ///
+  bool isFrameAllocated(uint8_t frameIndex) const;
+
+  /// @brief Check if a blink&PWM set is allocated.
+  ///
+  /// Sets outside of the RAM configuration are reported as allocated.
+  ///
+  bool isPwmSetAllocated(uint8_t setIndex) const;
+
+  /// @brief Get the number of usable frames in the RAM configuration.
+  ///
+  uint8_t getFrameCount() const;
+
+  /// @brief Get the number of free frames.
+  ///
+  uint8_t getFreeFrameCount() const;
+
+  /// @brief Get the size of the largest contiguous range of free frames.
+  ///
+  uint8_t getLargestFreeFrameRange() const;
+
+  /// @brief Get the fragmentation of the free frames.
+  ///
+  /// @return The percentage of free frames outside of the largest free range,
+  ///   from 0 (not fragmented) to 100.
+  ///
+  uint8_t getFragmentation() const;
+
+  /// @brief Get the number of usable blink&PWM sets in the RAM configuration.
+  ///
+  uint8_t getPwmSetCount() const;
+
+  /// @brief Get the number of free blink&PWM sets.
+  ///
+  uint8_t getFreePwmSetCount() const;
+
+public:
+  /// @brief Get the number of usable frames for a RAM configuration.
+  ///
+  /// @param ramConfiguration The RAM configuration.
+  /// @param isDotCorrectionUsed If the dot correction is used, which reserves the last frame.
+  ///
+  static uint8_t getFrameCount(AS1130::RamConfiguration ramConfiguration, bool isDotCorrectionUsed);
+
+  /// @brief Get the number of blink&PWM sets for a RAM configuration.
+  ///
+  /// @param ramConfiguration The RAM configuration.
+  ///
+  static uint8_t getPwmSetCount(AS1130::RamConfiguration ramConfiguration);
+
+private:
+  /// @brief Find the smallest free range with at least the given size.
+  ///
+  int8_t findFreeRange(uint8_t count) const;
+
+  /// @brief Mark a range of frames.
+  ///
+  void markFrames(uint8_t firstFrameIndex, uint8_t count, bool allocated);
+
+private:
+  AS1130::RamConfiguration _ramConfiguration; ///< The RAM configuration.
+  uint8_t _frameCount; ///< The number of usable frames.
+  uint8_t _frameUsage[5]; ///< One bit for each allocated frame.
+  uint8_t _pwmSetUsage; ///< One bit for each allocated blink&PWM set.
+};
+
+
+}
+
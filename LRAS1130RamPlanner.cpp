@@ -0,0 +1,168 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130RamPlanner.h"
+
+
+namespace lr {
+
+
+AS1130RamPlanner::AS1130RamPlanner(bool isDotCorrectionUsed)
+  : _isDotCorrectionUsed(isDotCorrectionUsed), _animationCount(0), _pictureCount(0), _pwmSetCount(1),
+    _nonResidentCount(0), _allocator(AS1130::RamConfiguration1, isDotCorrectionUsed)
+{
+}
+
+
+void AS1130RamPlanner::setAnimations(const uint8_t *frameCounts, uint8_t count)
+{
+  _animationCount = (count > cMaximumItemCount ? cMaximumItemCount : count);
+  for (uint8_t i = 0; i < _animationCount; ++i) {
+    _animationFrameCount[i] = frameCounts[i];
+  }
+}
+
+
+void AS1130RamPlanner::setPictureCount(uint8_t count)
+{
+  _pictureCount = (count > cMaximumItemCount ? cMaximumItemCount : count);
+}
+
+
+void AS1130RamPlanner::setPwmSetCount(uint8_t count)
+{
+  _pwmSetCount = (count == 0 ? 1 : count);
+}
+
+
+bool AS1130RamPlanner::plan()
+{
+  AS1130::RamConfiguration bestConfiguration = AS1130::RamConfiguration1;
+  uint8_t bestNonResidentCount = 0xff;
+  for (uint8_t configuration = AS1130::RamConfiguration1; configuration <= AS1130::RamConfiguration6; ++configuration) {
+    const uint8_t nonResidentCount = layout(static_cast<AS1130::RamConfiguration>(configuration));
+    if (nonResidentCount < bestNonResidentCount) {
+      bestConfiguration = static_cast<AS1130::RamConfiguration>(configuration);
+      bestNonResidentCount = nonResidentCount;
+    }
+  }
+  _nonResidentCount = layout(bestConfiguration);
+  return _nonResidentCount == 0;
+}
+
+
+void AS1130RamPlanner::apply(AS1130 &driver) const
+{
+  driver.setRamConfiguration(_allocator.getRamConfiguration());
+  driver.setDotCorrectionEnabled(_isDotCorrectionUsed);
+}
+
+
+AS1130::RamConfiguration AS1130RamPlanner::getRamConfiguration() const
+{
+  return _allocator.getRamConfiguration();
+}
+
+
+int8_t AS1130RamPlanner::getAnimationFrameIndex(uint8_t animationIndex) const
+{
+  if (animationIndex >= _animationCount) {
+    return -1;
+  }
+  return _animationFrameIndex[animationIndex];
+}
+
+
+int8_t AS1130RamPlanner::getPictureFrameIndex(uint8_t pictureIndex) const
+{
+  if (pictureIndex >= _pictureCount) {
+    return -1;
+  }
+  return _pictureFrameIndex[pictureIndex];
+}
+
+
+int8_t AS1130RamPlanner::getPwmSetIndex(uint8_t pwmSetIndex) const
+{
+  if (pwmSetIndex >= _pwmSetCount || pwmSetIndex >= _allocator.getPwmSetCount()) {
+    return -1;
+  }
+  return static_cast<int8_t>(pwmSetIndex);
+}
+
+
+uint8_t AS1130RamPlanner::getNonResidentCount() const
+{
+  return _nonResidentCount;
+}
+
+
+AS1130RamAllocator& AS1130RamPlanner::getAllocator()
+{
+  return _allocator;
+}
+
+
+uint8_t AS1130RamPlanner::layout(AS1130::RamConfiguration ramConfiguration)
+{
+  _allocator.reset(ramConfiguration, _isDotCorrectionUsed);
+  uint8_t nonResidentCount = 0;
+  // Sets are assigned in order, sets beyond the configuration are not resident.
+  for (uint8_t i = 0; i < _pwmSetCount; ++i) {
+    if (_allocator.allocatePwmSet() < 0) {
+      ++nonResidentCount;
+    }
+  }
+  // Pictures use a single frame, so they are placed first.
+  for (uint8_t i = 0; i < _pictureCount; ++i) {
+    _pictureFrameIndex[i] = _allocator.allocateFrame();
+    if (_pictureFrameIndex[i] < 0) {
+      ++nonResidentCount;
+    }
+  }
+  // Place the animations from the smallest to the largest one.
+  for (uint8_t i = 0; i < _animationCount; ++i) {
+    _animationFrameIndex[i] = -1;
+  }
+  for (uint8_t placedCount = 0; placedCount < _animationCount; ++placedCount) {
+    uint8_t next = 0xff;
+    for (uint8_t i = 0; i < _animationCount; ++i) {
+      if (_animationFrameIndex[i] == -1 && (next == 0xff || _animationFrameCount[i] < _animationFrameCount[next])) {
+        next = i;
+      }
+    }
+    const int8_t frameIndex = _allocator.allocateFrames(_animationFrameCount[next]);
+    if (frameIndex < 0) {
+      // Mark the animation as handled, but not resident.
+      _animationFrameIndex[next] = -2;
+      ++nonResidentCount;
+    } else {
+      _animationFrameIndex[next] = frameIndex;
+    }
+  }
+  for (uint8_t i = 0; i < _animationCount; ++i) {
+    if (_animationFrameIndex[i] < 0) {
+      _animationFrameIndex[i] = -1;
+    }
+  }
+  return nonResidentCount;
+}
+
+
+}
+
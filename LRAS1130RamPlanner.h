@@ -0,0 +1,154 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130RamAllocator.h"
+
+
+namespace lr {
+
+
+/// @brief Choose the RAM configuration and layout for the content of an application.
+///
+/// Describe the animations, pictures and blink&PWM sets the application needs,
+/// then call plan(). The planner tries all six RAM configurations and chooses
+/// the one which keeps the most animations, pictures and sets resident in the
+/// chip. If several configurations keep everything resident, the one with the
+/// most frames left is chosen.
+///
+/// Content which does not fit has no index in the layout and has to be
+/// uploaded at runtime. Smaller animations are placed first, so the number of
+/// items which have to be uploaded at runtime is as small as possible.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// const uint8_t animationFrames[] = {12, 8};
+/// lr::AS1130RamPlanner planner(true);
+/// planner.setAnimations(animationFrames, 2);
+/// planner.setPictureCount(4);
+/// planner.setPwmSetCount(2);
+/// planner.plan();
+/// planner.apply(ledDriver);
+/// ledDriver.setOnOffFrame24x5(planner.getPictureFrameIndex(0), icon);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130RamPlanner
+{
+public:
+  /// @brief The maximum number of animations and pictures.
+  ///
+  static const uint8_t cMaximumItemCount = 36;
+
+public:
+  /// @brief Create a new planner without content.
+  ///
+  /// @param isDotCorrectionUsed If the dot correction is used, which reserves the last frame.
+  ///
+  explicit AS1130RamPlanner(bool isDotCorrectionUsed = false);
+
+public:
+  /// @brief Set the animations.
+  ///
+  /// @param frameCounts An array with the number of frames of each animation.
+  /// @param count The number of animations, at most 36.
+  ///
+  void setAnimations(const uint8_t *frameCounts, uint8_t count);
+
+  /// @brief Set the number of pictures.
+  ///
+  /// @param count The number of pictures, at most 36.
+  ///
+  void setPictureCount(uint8_t count);
+
+  /// @brief Set the number of distinct blink&PWM sets.
+  ///
+  /// @param count The number of sets. Zero is handled like one.
+  ///
+  void setPwmSetCount(uint8_t count);
+
+  /// @brief Choose the RAM configuration and create the layout.
+  ///
+  /// @return `true` if all content is resident in the chip.
+  ///
+  bool plan();
+
+  /// @brief Write the chosen RAM configuration and dot correction setting to the chip.
+  ///
+  /// @param driver The driver for the chip.
+  ///
+  void apply(AS1130 &driver) const;
+
+  /// @brief Get the chosen RAM configuration.
+  ///
+  AS1130::RamConfiguration getRamConfiguration() const;
+
+  /// @brief Get the first frame of an animation.
+  ///
+  /// @param animationIndex The index of the animation.
+  /// @return The frame index, or -1 if the animation is not resident.
+  ///
+  int8_t getAnimationFrameIndex(uint8_t animationIndex) const;
+
+  /// @brief Get the frame of a picture.
+  ///
+  /// @param pictureIndex The index of the picture.
+  /// @return The frame index, or -1 if the picture is not resident.
+  ///
+  int8_t getPictureFrameIndex(uint8_t pictureIndex) const;
+
+  /// @brief Get the chip set for a blink&PWM set of the application.
+  ///
+  /// @param pwmSetIndex The index of the set in the application.
+  /// @return The set index in the chip, or -1 if the set is not resident.
+  ///
+  int8_t getPwmSetIndex(uint8_t pwmSetIndex) const;
+
+  /// @brief Get the number of animations, pictures and sets which are not resident.
+  ///
+  uint8_t getNonResidentCount() const;
+
+  /// @brief Get the allocator with the layout.
+  ///
+  /// Use this allocator for content which is added at runtime.
+  ///
+  AS1130RamAllocator& getAllocator();
+
+private:
+  /// @brief Create the layout for a RAM configuration.
+  ///
+  /// @return The number of animations, pictures and sets which are not resident.
+  ///
+  uint8_t layout(AS1130::RamConfiguration ramConfiguration);
+
+private:
+  bool _isDotCorrectionUsed; ///< If the dot correction is used.
+  uint8_t _animationCount; ///< The number of animations.
+  uint8_t _pictureCount; ///< The number of pictures.
+  uint8_t _pwmSetCount; ///< The number of distinct blink&PWM sets.
+  uint8_t _nonResidentCount; ///< The number of items which are not resident.
+  uint8_t _animationFrameCount[cMaximumItemCount]; ///< The number of frames of each animation.
+  int8_t _animationFrameIndex[cMaximumItemCount]; ///< The first frame of each animation.
+  int8_t _pictureFrameIndex[cMaximumItemCount]; ///< The frame of each picture.
+  AS1130RamAllocator _allocator; ///< The allocator with the layout.
+};
+
+
+}
+
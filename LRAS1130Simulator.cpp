@@ -0,0 +1,519 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#include "LRAS1130Simulator.h"
+
+
+#include <cstring>
+
+
+namespace lr {
+
+
+namespace {
+
+
+/// The address for the register selection.
+///
+const uint8_t cRegisterSelectionAddress = 0xfd;
+
+/// The frame delay unit in microseconds for each clock frequency.
+///
+/// The unit is 32.5ms with the 1MHz clock and scales with the clock.
+///
+const uint32_t cFrameDelayUnitUs[] = {32500, 65000, 260000, 1015625};
+
+/// The number of LED segments.
+///
+const uint8_t cSegmentCount = 12;
+
+/// The number of LEDs in one segment.
+///
+const uint8_t cLedsPerSegment = 11;
+
+/// The simulated bus frequency in Hz.
+///
+const uint32_t cBusFrequencyHz = 400000;
+
+/// The number of bus clock cycles per transferred byte, including the acknowledge.
+///
+const uint32_t cCyclesPerByte = 9;
+
+/// The number of bus clock cycles for the start and stop condition of a message.
+///
+const uint32_t cCyclesPerMessage = 2;
+
+
+}
+
+
+const uint8_t AS1130SimulatedChip::cFrameCount;
+const uint8_t AS1130SimulatedChip::cFrameSize;
+const uint8_t AS1130SimulatedChip::cBlinkAndPwmSetCount;
+const uint8_t AS1130SimulatedChip::cBlinkAndPwmSetSize;
+const uint8_t AS1130SimulatedChip::cDotCorrectionSize;
+const uint8_t AS1130SimulatedChip::cControlRegisterCount;
+const uint8_t AS1130SimulatorBus::cChipCount;
+
+
+AS1130SimulatedChip::AS1130SimulatedChip(AS1130::ChipAddress chipAddress)
+  : _chipAddress(chipAddress), _isConnected(true)
+{
+  std::memset(_openLeds, 0, sizeof(_openLeds));
+  reset();
+}
+
+
+uint8_t AS1130SimulatedChip::getChipAddress() const
+{
+  return _chipAddress;
+}
+
+
+void AS1130SimulatedChip::powerOnReset()
+{
+  reset();
+  _controlRegisters[AS1130::CR_InterruptStatus] = AS1130::IMF_POR;
+}
+
+
+void AS1130SimulatedChip::setConnected(bool connected)
+{
+  _isConnected = connected;
+}
+
+
+bool AS1130SimulatedChip::isConnected() const
+{
+  return _isConnected;
+}
+
+
+void AS1130SimulatedChip::setLedOpen(uint8_t ledIndex, bool isOpen)
+{
+  const uint8_t byteIndex = (ledIndex>>3);
+  if (byteIndex >= sizeof(_openLeds)) {
+    return;
+  }
+  const uint8_t bitMask = (1<<(ledIndex&0x7));
+  if (isOpen) {
+    _openLeds[byteIndex] |= bitMask;
+  } else {
+    _openLeds[byteIndex] &= ~bitMask;
+  }
+}
+
+
+void AS1130SimulatedChip::advanceTime(uint32_t microseconds)
+{
+  const uint32_t frameDelayUs = getFrameDelayUs();
+  if (!_isMoviePlaying || frameDelayUs == 0) {
+    return;
+  }
+  _frameTimeUs += microseconds;
+  while (_isMoviePlaying && _frameTimeUs >= frameDelayUs) {
+    _frameTimeUs -= frameDelayUs;
+    advanceMovieFrame();
+  }
+}
+
+
+void AS1130SimulatedChip::write(uint8_t registerAddress, const uint8_t *data, uint16_t length)
+{
+  if (registerAddress == cRegisterSelectionAddress) {
+    if (length > 0) {
+      _registerSelection = data[length-1];
+    }
+    return;
+  }
+  _addressPointer = registerAddress;
+  for (uint16_t i = 0; i < length; ++i) {
+    if (_registerSelection == AS1130::RS_Control) {
+      writeControlRegister(_addressPointer, data[i]);
+    } else {
+      uint8_t *memory = getMemory(_addressPointer);
+      if (memory != nullptr) {
+        *memory = data[i];
+      }
+    }
+    ++_addressPointer;
+  }
+}
+
+
+void AS1130SimulatedChip::read(uint8_t *data, uint16_t length)
+{
+  for (uint16_t i = 0; i < length; ++i) {
+    data[i] = readMemory(_addressPointer);
+    ++_addressPointer;
+  }
+}
+
+
+uint8_t AS1130SimulatedChip::getRegisterSelection() const
+{
+  return _registerSelection;
+}
+
+
+const uint8_t* AS1130SimulatedChip::getOnOffFrame(uint8_t frameIndex) const
+{
+  return _onOffFrames[frameIndex];
+}
+
+
+const uint8_t* AS1130SimulatedChip::getBlinkAndPwmSet(uint8_t setIndex) const
+{
+  return _blinkAndPwmSets[setIndex];
+}
+
+
+const uint8_t* AS1130SimulatedChip::getDotCorrection() const
+{
+  return _dotCorrection;
+}
+
+
+uint8_t AS1130SimulatedChip::getControlRegister(uint8_t address) const
+{
+  if (address == AS1130::CR_Status) {
+    uint8_t status = (getDisplayedFrame()<<2);
+    if (_isMoviePlaying) {
+      status |= AS1130::SF_MovieOn;
+    }
+    return status;
+  }
+  if (address >= cControlRegisterCount) {
+    return 0x00;
+  }
+  return _controlRegisters[address];
+}
+
+
+bool AS1130SimulatedChip::isMoviePlaying() const
+{
+  return _isMoviePlaying;
+}
+
+
+uint8_t AS1130SimulatedChip::getDisplayedFrame() const
+{
+  const uint8_t movie = _controlRegisters[AS1130::CR_Movie];
+  if ((movie & AS1130::MF_DisplayMovie) != 0) {
+    return (movie & AS1130::MF_MovieAddressMask) + _moviePosition;
+  }
+  const uint8_t picture = _controlRegisters[AS1130::CR_Picture];
+  if ((picture & AS1130::PF_DisplayPicture) != 0) {
+    return (picture & AS1130::PF_PictureAddressMask);
+  }
+  return 0;
+}
+
+
+uint8_t* AS1130SimulatedChip::getMemory(uint8_t address)
+{
+  const uint8_t selection = _registerSelection;
+  if (selection >= AS1130::RS_OnOffFrame && selection < AS1130::RS_OnOffFrame + cFrameCount) {
+    if (address < cFrameSize) {
+      return &_onOffFrames[selection - AS1130::RS_OnOffFrame][address];
+    }
+  } else if (selection >= AS1130::RS_BlinkAndPwmSet && selection < AS1130::RS_BlinkAndPwmSet + cBlinkAndPwmSetCount) {
+    if (address < cBlinkAndPwmSetSize) {
+      return &_blinkAndPwmSets[selection - AS1130::RS_BlinkAndPwmSet][address];
+    }
+  } else if (selection == AS1130::RS_DotCorrection) {
+    if (address < cDotCorrectionSize) {
+      return &_dotCorrection[address];
+    }
+  }
+  return nullptr;
+}
+
+
+void AS1130SimulatedChip::writeControlRegister(uint8_t address, uint8_t data)
+{
+  if (address > AS1130::CR_ClockSynchronization) {
+    // All other registers are read only.
+    return;
+  }
+  if (address == AS1130::CR_ShutdownAndOpenShort && (data & AS1130::SOSF_Initialize) != 0) {
+    reset();
+    return;
+  }
+  _controlRegisters[address] = data;
+  switch (address) {
+  case AS1130::CR_Movie:
+    if ((data & AS1130::MF_DisplayMovie) != 0) {
+      startMovie();
+    } else {
+      _isMoviePlaying = false;
+      _moviePosition = 0;
+    }
+    break;
+  case AS1130::CR_Picture:
+    if ((data & AS1130::PF_DisplayPicture) != 0) {
+      if ((_controlRegisters[AS1130::CR_ShutdownAndOpenShort] & AS1130::SOSF_AutoTest) != 0) {
+        runLedTest();
+      }
+      checkInterruptFrame();
+    }
+    break;
+  case AS1130::CR_ShutdownAndOpenShort:
+    if ((data & AS1130::SOSF_ManualTest) != 0) {
+      runLedTest();
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+
+uint8_t AS1130SimulatedChip::readMemory(uint8_t address)
+{
+  if (_registerSelection == AS1130::RS_Control) {
+    const uint8_t data = getControlRegister(address);
+    if (address == AS1130::CR_InterruptStatus) {
+      // Reading the interrupt status clears it.
+      _controlRegisters[AS1130::CR_InterruptStatus] = 0x00;
+    }
+    return data;
+  }
+  const uint8_t *memory = getMemory(address);
+  if (memory != nullptr) {
+    return *memory;
+  }
+  return 0x00;
+}
+
+
+void AS1130SimulatedChip::reset()
+{
+  _registerSelection = AS1130::RS_NOP;
+  _addressPointer = 0;
+  std::memset(_onOffFrames, 0, sizeof(_onOffFrames));
+  std::memset(_blinkAndPwmSets, 0, sizeof(_blinkAndPwmSets));
+  std::memset(_dotCorrection, 0, sizeof(_dotCorrection));
+  std::memset(_controlRegisters, 0, sizeof(_controlRegisters));
+  _isMoviePlaying = false;
+  _moviePosition = 0;
+  _movieLoop = 0;
+  _frameTimeUs = 0;
+}
+
+
+void AS1130SimulatedChip::runLedTest()
+{
+  bool hasOpenLed = false;
+  for (uint8_t segment = 0; segment < cSegmentCount; ++segment) {
+    for (uint8_t led = 0; led < cLedsPerSegment; ++led) {
+      const uint8_t ledIndex = (segment<<4) + led;
+      const uint8_t byteIndex = (ledIndex>>3);
+      const uint8_t bitMask = (1<<(ledIndex&0x7));
+      uint8_t &openLedRegister = _controlRegisters[AS1130::CR_OpenLedBase + byteIndex];
+      if ((_openLeds[byteIndex] & bitMask) != 0) {
+        openLedRegister &= ~bitMask;
+        hasOpenLed = true;
+      } else {
+        openLedRegister |= bitMask;
+      }
+    }
+  }
+  if (hasOpenLed) {
+    _controlRegisters[AS1130::CR_InterruptStatus] |= AS1130::IMF_OpenTestError;
+  }
+}
+
+
+void AS1130SimulatedChip::startMovie()
+{
+  _isMoviePlaying = true;
+  _moviePosition = 0;
+  _movieLoop = 0;
+  _frameTimeUs = 0;
+  if ((_controlRegisters[AS1130::CR_ShutdownAndOpenShort] & AS1130::SOSF_AutoTest) != 0) {
+    runLedTest();
+  }
+  checkInterruptFrame();
+}
+
+
+void AS1130SimulatedChip::advanceMovieFrame()
+{
+  const uint8_t frameCount = (_controlRegisters[AS1130::CR_MovieMode] & AS1130::MMF_MovieFramesMask) + 1;
+  ++_moviePosition;
+  if (_moviePosition >= frameCount) {
+    ++_movieLoop;
+    const uint8_t loops = (_controlRegisters[AS1130::CR_DisplayOption] & AS1130::DOF_LoopsMask);
+    const uint8_t loopCount = (loops == 0 ? 1 : (loops>>5));
+    if (loops != AS1130::MovieLoopEndless && _movieLoop >= loopCount) {
+      _isMoviePlaying = false;
+      if ((_controlRegisters[AS1130::CR_MovieMode] & AS1130::MMF_EndLast) != 0) {
+        _moviePosition = frameCount - 1;
+      } else {
+        _moviePosition = 0;
+      }
+      _controlRegisters[AS1130::CR_InterruptStatus] |= AS1130::IMF_MovieFinished;
+      return;
+    }
+    _moviePosition = 0;
+  }
+  checkInterruptFrame();
+}
+
+
+void AS1130SimulatedChip::checkInterruptFrame()
+{
+  if (getDisplayedFrame() == _controlRegisters[AS1130::CR_InterruptFrameDefinition]) {
+    _controlRegisters[AS1130::CR_InterruptStatus] |= AS1130::IMF_SelectedPicture;
+  }
+}
+
+
+uint32_t AS1130SimulatedChip::getFrameDelayUs() const
+{
+  if ((_controlRegisters[AS1130::CR_ShutdownAndOpenShort] & AS1130::SOSF_Shutdown) == 0) {
+    // The chip is in shutdown mode.
+    return 0;
+  }
+  const uint8_t frameDelay = (_controlRegisters[AS1130::CR_FrameTimeScroll] & AS1130::FTSF_FrameDelay);
+  const uint8_t clock = ((_controlRegisters[AS1130::CR_ClockSynchronization] >> 2) & 0x3);
+  return frameDelay * cFrameDelayUnitUs[clock];
+}
+
+
+AS1130SimulatorBus::AS1130SimulatorBus(uint16_t maximumDataLength)
+  : _maximumDataLength(maximumDataLength), _transferCount(0), _messageCount(0), _bytesWritten(0), _bytesRead(0), _timeUs(0)
+{
+  for (uint8_t i = 0; i < cChipCount; ++i) {
+    _chips[i] = nullptr;
+  }
+}
+
+
+void AS1130SimulatorBus::attachChip(AS1130SimulatedChip &chip)
+{
+  _chips[chip.getChipAddress() & 0x0f] = &chip;
+}
+
+
+void AS1130SimulatorBus::detachChip(AS1130SimulatedChip &chip)
+{
+  AS1130SimulatedChip *&slot = _chips[chip.getChipAddress() & 0x0f];
+  if (slot == &chip) {
+    slot = nullptr;
+  }
+}
+
+
+void AS1130SimulatorBus::advanceTime(uint32_t microseconds)
+{
+  _timeUs += microseconds;
+  for (uint8_t i = 0; i < cChipCount; ++i) {
+    if (_chips[i] != nullptr) {
+      _chips[i]->advanceTime(microseconds);
+    }
+  }
+}
+
+
+uint32_t AS1130SimulatorBus::getTransferCount() const
+{
+  return _transferCount;
+}
+
+
+uint32_t AS1130SimulatorBus::getMessageCount() const
+{
+  return _messageCount;
+}
+
+
+uint32_t AS1130SimulatorBus::getBytesWritten() const
+{
+  return _bytesWritten;
+}
+
+
+uint32_t AS1130SimulatorBus::getBytesRead() const
+{
+  return _bytesRead;
+}
+
+
+void AS1130SimulatorBus::resetCounters()
+{
+  _transferCount = 0;
+  _messageCount = 0;
+  _bytesWritten = 0;
+  _bytesRead = 0;
+}
+
+
+bool AS1130SimulatorBus::transfer(uint8_t chipAddress, const Message *messages, uint8_t count)
+{
+  ++_transferCount;
+  // Every message sends the chip address, a write also sends the register address.
+  uint32_t cycles = 0;
+  for (uint8_t i = 0; i < count; ++i) {
+    const uint32_t byteCount = messages[i].length + (messages[i].isRead ? 1 : 2);
+    cycles += byteCount * cCyclesPerByte + cCyclesPerMessage;
+  }
+  advanceTime(cycles * 1000000 / cBusFrequencyHz);
+  AS1130SimulatedChip *chip = nullptr;
+  if ((chipAddress & 0xf0) == AS1130::ChipBaseAddress) {
+    chip = _chips[chipAddress & 0x0f];
+  }
+  for (uint8_t i = 0; i < count; ++i) {
+    const Message &message = messages[i];
+    ++_messageCount;
+    if (chip == nullptr || !chip->isConnected() || message.length > _maximumDataLength) {
+      return false;
+    }
+    if (message.isRead) {
+      chip->read(message.readData, message.length);
+      _bytesRead += message.length;
+    } else {
+      chip->write(message.registerAddress, message.writeData, message.length);
+      _bytesWritten += message.length + 1;
+    }
+  }
+  return true;
+}
+
+
+uint16_t AS1130SimulatorBus::getMaximumDataLength() const
+{
+  return _maximumDataLength;
+}
+
+
+void AS1130SimulatorBus::delayMs(uint16_t milliseconds)
+{
+  advanceTime(static_cast<uint32_t>(milliseconds) * 1000);
+}
+
+
+uint32_t AS1130SimulatorBus::getTimeUs()
+{
+  return _timeUs;
+}
+
+
+}
+
@@ -0,0 +1,324 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130.h"
+#include "LRAS1130Bus.h"
+
+#include <cinttypes>
+
+
+namespace lr {
+
+
+/// @brief A software model of a single AS1130 chip.
+///
+/// The model keeps the register selection, all on/off frames, blink&PWM sets,
+/// the dot correction data, the control registers and the open LED registers.
+/// Attach it to an AS1130SimulatorBus to use it with the AS1130 driver.
+///
+/// The model does not check the RAM configuration, all 36 frames and 6 sets
+/// are always available. LED tests finish immediately. Movie playback is
+/// only modeled if the time is advanced using advanceTime() or the
+/// `delayMs()` function of the bus.
+///
+class AS1130SimulatedChip
+{
+public:
+  /// @brief The number of on/off frames.
+  ///
+  static const uint8_t cFrameCount = 36;
+
+  /// @brief The number of bytes in one on/off frame.
+  ///
+  static const uint8_t cFrameSize = 0x18;
+
+  /// @brief The number of blink&PWM sets.
+  ///
+  static const uint8_t cBlinkAndPwmSetCount = 6;
+
+  /// @brief The number of bytes in one blink&PWM set.
+  ///
+  static const uint8_t cBlinkAndPwmSetSize = 0x9c;
+
+  /// @brief The number of bytes of dot correction data.
+  ///
+  static const uint8_t cDotCorrectionSize = 0x0c;
+
+  /// @brief The number of control register addresses, including the open LED registers.
+  ///
+  static const uint8_t cControlRegisterCount = 0x38;
+
+public:
+  /// @brief Create a new simulated chip.
+  ///
+  /// @param chipAddress The I2C address of the chip.
+  ///
+  explicit AS1130SimulatedChip(AS1130::ChipAddress chipAddress = AS1130::ChipAddress0);
+
+public:
+  /// @brief Get the I2C address of this chip.
+  ///
+  uint8_t getChipAddress() const;
+
+  /// @brief Simulate a power on reset.
+  ///
+  /// This clears all memory and registers and sets the IMF_POR flag in
+  /// the interrupt status register.
+  ///
+  void powerOnReset();
+
+  /// @brief Set if the chip answers on the bus.
+  ///
+  /// A disconnected chip does not acknowledge any message.
+  ///
+  /// @param connected True if the chip answers, false if not.
+  ///
+  void setConnected(bool connected);
+
+  /// @brief Check if the chip answers on the bus.
+  ///
+  bool isConnected() const;
+
+  /// @brief Mark a LED as open.
+  ///
+  /// The open LED registers are updated at the next LED test.
+  ///
+  /// @param ledIndex The index of the LED in the chip numbering (0x00-0xba).
+  /// @param isOpen True if the LED is open, false if it is working.
+  ///
+  void setLedOpen(uint8_t ledIndex, bool isOpen);
+
+  /// @brief Advance the time of the chip.
+  ///
+  /// This advances a running movie, depending on the frame delay and the
+  /// clock frequency set in the control registers.
+  ///
+  /// @param microseconds The elapsed time in microseconds.
+  ///
+  void advanceTime(uint32_t microseconds);
+
+public: // Bus side.
+  /// @brief Process a write message.
+  ///
+  /// @param registerAddress The first byte of the message.
+  /// @param data The data bytes after the first byte.
+  /// @param length The number of data bytes.
+  ///
+  void write(uint8_t registerAddress, const uint8_t *data, uint16_t length);
+
+  /// @brief Process a read message.
+  ///
+  /// @param data The buffer for the read bytes.
+  /// @param length The number of bytes to read.
+  ///
+  void read(uint8_t *data, uint16_t length);
+
+public: // Inspection.
+  /// @brief Get the current register selection.
+  ///
+  uint8_t getRegisterSelection() const;
+
+  /// @brief Get the data of an on/off frame.
+  ///
+  /// @param frameIndex The index of the frame, between 0 and 35.
+  /// @return A pointer to the 24 bytes of the frame.
+  ///
+  const uint8_t* getOnOffFrame(uint8_t frameIndex) const;
+
+  /// @brief Get the data of a blink&PWM set.
+  ///
+  /// @param setIndex The index of the set, between 0 and 5.
+  /// @return A pointer to the 156 bytes of the set.
+  ///
+  const uint8_t* getBlinkAndPwmSet(uint8_t setIndex) const;
+
+  /// @brief Get the dot correction data.
+  ///
+  /// @return A pointer to the 12 bytes of dot correction data.
+  ///
+  const uint8_t* getDotCorrection() const;
+
+  /// @brief Get the value of a control register.
+  ///
+  /// The status register is returned as it would be read from the chip. The
+  /// interrupt status is not cleared by this function.
+  ///
+  /// @param address The address of the control register.
+  ///
+  uint8_t getControlRegister(uint8_t address) const;
+
+  /// @brief Check if a movie is playing.
+  ///
+  bool isMoviePlaying() const;
+
+  /// @brief Get the currently displayed frame.
+  ///
+  uint8_t getDisplayedFrame() const;
+
+private:
+  /// @brief Get a pointer to a memory location in the selected register bank.
+  ///
+  /// @return The pointer, or `nullptr` if the location does not exist.
+  ///
+  uint8_t* getMemory(uint8_t address);
+
+  /// @brief Write a single byte to a control register.
+  ///
+  void writeControlRegister(uint8_t address, uint8_t data);
+
+  /// @brief Read a single byte from the selected register bank.
+  ///
+  uint8_t readMemory(uint8_t address);
+
+  /// @brief Reset all memory and registers.
+  ///
+  void reset();
+
+  /// @brief Update the open LED registers.
+  ///
+  void runLedTest();
+
+  /// @brief Start playing the movie.
+  ///
+  void startMovie();
+
+  /// @brief Advance the movie by one frame.
+  ///
+  void advanceMovieFrame();
+
+  /// @brief Set the selected picture interrupt if the given frame is reached.
+  ///
+  void checkInterruptFrame();
+
+  /// @brief Get the frame delay in microseconds.
+  ///
+  /// @return The delay, or zero if the movie does not advance.
+  ///
+  uint32_t getFrameDelayUs() const;
+
+private:
+  uint8_t _chipAddress; ///< The I2C address of this chip.
+  bool _isConnected; ///< If the chip answers on the bus.
+  uint8_t _registerSelection; ///< The current register selection.
+  uint8_t _addressPointer; ///< The address for the next read or write.
+  uint8_t _onOffFrames[cFrameCount][cFrameSize]; ///< The on/off frames.
+  uint8_t _blinkAndPwmSets[cBlinkAndPwmSetCount][cBlinkAndPwmSetSize]; ///< The blink&PWM sets.
+  uint8_t _dotCorrection[cDotCorrectionSize]; ///< The dot correction data.
+  uint8_t _controlRegisters[cControlRegisterCount]; ///< The control registers and open LED registers.
+  uint8_t _openLeds[cControlRegisterCount-AS1130::CR_OpenLedBase]; ///< Bit mask of the LEDs which are open.
+  bool _isMoviePlaying; ///< If a movie is playing.
+  uint8_t _moviePosition; ///< The position in the movie, starting from the first frame.
+  uint8_t _movieLoop; ///< The number of completed loops.
+  uint32_t _frameTimeUs; ///< The time elapsed for the current movie frame.
+};
+
+
+/// @brief A bus implementation which connects simulated AS1130 chips.
+///
+/// Use this bus to run the AS1130 driver without hardware, e.g. for tests
+/// on a host. The bus counts all transfers, messages and bytes.
+///
+/// The bus keeps a simulated time. It advances with delayMs(), advanceTime()
+/// and with every transfer, using the duration of the transfer on a 400kHz bus.
+///
+/// Example:
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// lr::AS1130SimulatorBus bus;
+/// lr::AS1130SimulatedChip chip(lr::AS1130::ChipAddress0);
+/// bus.attachChip(chip);
+/// lr::AS1130 ledDriver(bus, lr::AS1130::ChipAddress0);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+class AS1130SimulatorBus : public AS1130Bus
+{
+public:
+  /// @brief Create a new simulator bus.
+  ///
+  /// @param maximumDataLength The maximum number of data bytes per message.
+  ///   The default value matches the buffer of the Arduino Wire library.
+  ///
+  explicit AS1130SimulatorBus(uint16_t maximumDataLength = 31);
+
+public:
+  /// @brief Attach a chip to the bus.
+  ///
+  /// A chip attached at the same address replaces the previous one.
+  ///
+  /// @param chip The chip to attach. It has to exist as long as it is attached.
+  ///
+  void attachChip(AS1130SimulatedChip &chip);
+
+  /// @brief Detach a chip from the bus.
+  ///
+  /// @param chip The chip to detach.
+  ///
+  void detachChip(AS1130SimulatedChip &chip);
+
+  /// @brief Advance the simulated time and the time of all attached chips.
+  ///
+  /// @param microseconds The elapsed time in microseconds.
+  ///
+  void advanceTime(uint32_t microseconds);
+
+  /// @brief Get the number of calls to transfer().
+  ///
+  uint32_t getTransferCount() const;
+
+  /// @brief Get the number of transferred messages.
+  ///
+  uint32_t getMessageCount() const;
+
+  /// @brief Get the number of written bytes, including the register addresses.
+  ///
+  uint32_t getBytesWritten() const;
+
+  /// @brief Get the number of read bytes.
+  ///
+  uint32_t getBytesRead() const;
+
+  /// @brief Reset all counters to zero.
+  ///
+  void resetCounters();
+
+public: // Implement AS1130Bus
+  bool transfer(uint8_t chipAddress, const Message *messages, uint8_t count) override;
+  uint16_t getMaximumDataLength() const override;
+  void delayMs(uint16_t milliseconds) override;
+  uint32_t getTimeUs() override;
+
+private:
+  /// @brief The number of possible chip addresses.
+  ///
+  static const uint8_t cChipCount = 16;
+
+private:
+  uint16_t _maximumDataLength; ///< The maximum number of data bytes per message.
+  AS1130SimulatedChip *_chips[cChipCount]; ///< The attached chips, indexed by the low bits of the address.
+  uint32_t _transferCount; ///< The number of transfers.
+  uint32_t _messageCount; ///< The number of messages.
+  uint32_t _bytesWritten; ///< The number of written bytes.
+  uint32_t _bytesRead; ///< The number of read bytes.
+  uint32_t _timeUs; ///< The simulated time in microseconds.
+};
+
+
+}
+
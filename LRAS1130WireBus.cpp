@@ -0,0 +1,120 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#if defined(ARDUINO)
+
+
+#include "LRAS1130WireBus.h"
+
+#include <Arduino.h>
+
+
+namespace lr {
+
+
+namespace {
+
+
+/// The size of the transmit buffer of the I2C library.
+///
+#if defined(BUFFER_LENGTH)
+const uint8_t cWireBufferSize = BUFFER_LENGTH;
+#elif defined(I2C_BUFFER_LENGTH)
+const uint8_t cWireBufferSize = I2C_BUFFER_LENGTH;
+#else
+const uint8_t cWireBufferSize = 32;
+#endif
+
+
+}
+
+
+AS1130WireBus::AS1130WireBus(TwoWire &wire)
+  : _wire(wire)
+{
+}
+
+
+AS1130WireBus& AS1130WireBus::defaultBus()
+{
+  static AS1130WireBus bus(Wire);
+  return bus;
+}
+
+
+void AS1130WireBus::setTimeout(uint32_t microseconds)
+{
+#if defined(WIRE_HAS_TIMEOUT)
+  _wire.setWireTimeout(microseconds, true);
+#else
+  (void)microseconds;
+#endif
+}
+
+
+bool AS1130WireBus::transfer(uint8_t chipAddress, const Message *messages, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; ++i) {
+    const Message &message = messages[i];
+    if (message.isRead) {
+      const uint8_t length = static_cast<uint8_t>(message.length);
+      if (_wire.requestFrom(chipAddress, length) != length) {
+        return false;
+      }
+      for (uint8_t j = 0; j < length; ++j) {
+        message.readData[j] = _wire.read();
+      }
+    } else {
+      _wire.beginTransmission(chipAddress);
+      _wire.write(message.registerAddress);
+      if (message.length > 0) {
+        _wire.write(message.writeData, message.length);
+      }
+      if (_wire.endTransmission() != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+uint16_t AS1130WireBus::getMaximumDataLength() const
+{
+  // One byte of the buffer is used for the register address.
+  return cWireBufferSize - 1;
+}
+
+
+void AS1130WireBus::delayMs(uint16_t milliseconds)
+{
+  delay(milliseconds);
+}
+
+
+uint32_t AS1130WireBus::getTimeUs()
+{
+  return micros();
+}
+
+
+}
+
+
+#endif
+
@@ -0,0 +1,70 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+#pragma once
+
+
+#include "LRAS1130Bus.h"
+
+#include <Wire.h>
+
+
+namespace lr {
+
+
+/// @brief The AS1130 bus implementation using the Arduino "Wire" library.
+///
+/// This is the default bus for the AS1130 driver on Arduino compatible boards.
+/// Create an own instance to use a second I2C peripheral.
+///
+class AS1130WireBus : public AS1130Bus
+{
+public:
+  /// @brief Create a new bus instance.
+  ///
+  /// @param wire The I2C peripheral to use.
+  ///
+  explicit AS1130WireBus(TwoWire &wire);
+
+public:
+  /// @brief Get the bus instance for the global `Wire` object.
+  ///
+  static AS1130WireBus& defaultBus();
+
+  /// @brief Set the timeout for transfers.
+  ///
+  /// This only has an effect if the Wire library supports timeouts, which is
+  /// indicated by the `WIRE_HAS_TIMEOUT` macro.
+  ///
+  /// @param microseconds The timeout in microseconds, or zero to disable the timeout.
+  ///
+  void setTimeout(uint32_t microseconds);
+
+public: // Implement AS1130Bus
+  bool transfer(uint8_t chipAddress, const Message *messages, uint8_t count) override;
+  uint16_t getMaximumDataLength() const override;
+  void delayMs(uint16_t milliseconds) override;
+  uint32_t getTimeUs() override;
+
+private:
+  TwoWire &_wire; ///< The used I2C peripheral.
+};
+
+
+}
+
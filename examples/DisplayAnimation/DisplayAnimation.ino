@@ -24,27 +24,32 @@
 using namespace lr;
 AS1130 ledDriver;
 
-const uint8_t exampleFrame1[] = {
+constexpr uint8_t exampleBitmap1[] = {
   0b11111111, 0b11111111, 0b11111111,
   0b10000000, 0b00000000, 0b00000001,
   0b10000000, 0b00000000, 0b00000001,
   0b10000000, 0b00000000, 0b00000001,
   0b11111111, 0b11111111, 0b11111111};
 
-const uint8_t exampleFrame2[] = {
+constexpr uint8_t exampleBitmap2[] = {
   0b00000000, 0b00000000, 0b00000000,
   0b00111111, 0b11111111, 0b11111100,
   0b00100000, 0b00000000, 0b00000100,
   0b00111111, 0b11111111, 0b11111100,
   0b00000000, 0b00000000, 0b00000000};
 
-const uint8_t exampleFrame3[] = {
+constexpr uint8_t exampleBitmap3[] = {
   0b00000000, 0b00000000, 0b00000000,
   0b00000000, 0b00000000, 0b00000000,
   0b00001111, 0b11111111, 0b11110000,
   0b00000000, 0b00000000, 0b00000000,
   0b00000000, 0b00000000, 0b00000000};
 
+// Convert the bitmaps into the frame format of the chip at compile time.
+constexpr AS1130Frame exampleFrame1 = AS1130Frame::from24x5(exampleBitmap1);
+constexpr AS1130Frame exampleFrame2 = AS1130Frame::from24x5(exampleBitmap2);
+constexpr AS1130Frame exampleFrame3 = AS1130Frame::from24x5(exampleBitmap3);
+
 void setup() {
   Wire.begin();
   Serial.begin(9600);
@@ -62,10 +67,10 @@ void setup() {
 
   // Set-up everything.
   ledDriver.setRamConfiguration(AS1130::RamConfiguration1);
-  ledDriver.setOnOffFrame24x5(0, exampleFrame1);
-  ledDriver.setOnOffFrame24x5(1, exampleFrame2);
-  ledDriver.setOnOffFrame24x5(2, exampleFrame3);
-  ledDriver.setOnOffFrame24x5(3, exampleFrame2);
+  ledDriver.setOnOffFrame(0, exampleFrame1);
+  ledDriver.setOnOffFrame(1, exampleFrame2);
+  ledDriver.setOnOffFrame(2, exampleFrame3);
+  ledDriver.setOnOffFrame(3, exampleFrame2);
   ledDriver.setBlinkAndPwmSetAll(0);
   ledDriver.setCurrentSource(AS1130::Current30mA);
   ledDriver.setScanLimit(AS1130::ScanLimitFull);
@@ -25,13 +25,16 @@ using namespace lr;
 AS1130 ledDriver;
 
 
-const uint8_t exampleFrame1[] = {
+constexpr uint8_t exampleBitmap[] = {
   0b11111011, 0b11101111, 0b11111111,
   0b10001010, 0b00101000, 0b00000001,
   0b10001010, 0b00101000, 0b00000001,
   0b10001010, 0b00101000, 0b00000001,
   0b11111011, 0b11101111, 0b11111111};
 
+// Convert the bitmap into the frame format of the chip at compile time.
+constexpr AS1130Frame exampleFrame = AS1130Frame::from24x5(exampleBitmap);
+
 void setup() {
   Wire.begin();
   Serial.begin(9600);
@@ -49,19 +52,11 @@ void setup() {
 
   // Set-up everything.
   ledDriver.setRamConfiguration(AS1130::RamConfiguration1);
-  ledDriver.setOnOffFrame24x5(0, exampleFrame1);
-  ledDriver.setOnOffFrame24x5(1, exampleFrame2);
-  ledDriver.setOnOffFrame24x5(2, exampleFrame3);
-  ledDriver.setOnOffFrame24x5(3, exampleFrame2);
+  ledDriver.setOnOffFrame(0, exampleFrame);
   ledDriver.setBlinkAndPwmSetAll(0);
   ledDriver.setCurrentSource(AS1130::Current30mA);
   ledDriver.setScanLimit(AS1130::ScanLimitFull);
-  ledDriver.setMovieEndFrame(AS1130::MovieEndWithFirstFrame);
-  ledDriver.setMovieFrameCount(4);
-  ledDriver.setFrameDelayMs(33);
-  ledDriver.setMovieLoopCount(AS1130::MovieLoop6);
-  ledDriver.setScrollingEnabled(true);
-  ledDriver.startMovie(0);
+  ledDriver.startPicture(0);
   
   // Enable the chip
   ledDriver.startChip();
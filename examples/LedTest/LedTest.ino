@@ -58,12 +58,16 @@ void setup() {
   Serial.println(F("Run the LED test"));
   ledDriver.runManualTest();
 
+  // Read the status of all leds at once.
+  AS1130::LedStatusMap ledStatusMap;
+  ledDriver.readLedStatusMap(ledStatusMap);
+
   // Display the status of all leds.
   for (uint8_t ledIndex = 0x00; ledIndex < 0xbb; ++ledIndex) {
     Serial.print(F("LED 0x"));
     Serial.print(ledIndex, HEX);
     Serial.print(F(": "));
-    switch (ledDriver.getLedStatus(ledIndex)) {
+    switch (ledStatusMap.getLedStatus(ledIndex)) {
       case AS1130::LedStatusOk:
         Serial.println(F(" OK"));
         break;
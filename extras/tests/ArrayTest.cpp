@@ -0,0 +1,325 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130Array, using simulated chips.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/ArrayTest.cpp LRAS1130*.cpp -o array-test && ./array-test
+//
+#include "LRAS1130Array.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Check if a LED is on in a frame of the chip.
+///
+bool isLedOn(const uint8_t *frame, uint8_t ledIndex)
+{
+  const uint8_t led = (ledIndex & 0x0f);
+  return (frame[((ledIndex >> 4) << 1) + (led >> 3)] & (1 << (led & 0x07))) != 0;
+}
+
+
+/// Count the LEDs which are on in a frame of the chip.
+///
+uint8_t getLedOnCount(const uint8_t *frame)
+{
+  uint8_t count = 0;
+  for (uint8_t segment = 0; segment < 12; ++segment) {
+    for (uint8_t led = 0; led < 11; ++led) {
+      if (isLedOn(frame, (segment << 4) | led)) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+
+/// A pixel in the frame buffer and the matrix position it has to light.
+///
+struct Mapping {
+  uint16_t x; ///< The pixel in the frame buffer.
+  uint16_t y; ///< The pixel in the frame buffer.
+  uint8_t matrixX; ///< The LED in the matrix of the chip.
+  uint8_t matrixY; ///< The LED in the matrix of the chip.
+};
+
+
+/// Light single pixels and check the LED which is on.
+///
+void checkMappings(AS1130Array::TileLayout layout, AS1130Array::Orientation orientation,
+  const Mapping *mappings, uint8_t count, const char *name)
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  // Place the tile with an offset, in a frame buffer which is not a multiple of 8 wide.
+  uint8_t frameBuffer[5 * 30];
+  AS1130Array display(frameBuffer, 35, 30);
+  display.fill(false);
+  display.addChip(driver, 3, 2, layout, orientation);
+  for (uint8_t i = 0; i < count; ++i) {
+    const Mapping &mapping = mappings[i];
+    display.setPixel(3 + mapping.x, 2 + mapping.y, true);
+    display.update();
+    const uint8_t ledIndex = (layout == AS1130Array::Tile24x5
+      ? AS1130::getLedIndex24x5(mapping.matrixX, mapping.matrixY)
+      : AS1130::getLedIndex12x11(mapping.matrixX, mapping.matrixY));
+    check(getLedOnCount(chip.getOnOffFrame(0)) == 1, name);
+    check(isLedOn(chip.getOnOffFrame(0), ledIndex), name);
+    display.setPixel(3 + mapping.x, 2 + mapping.y, false);
+  }
+}
+
+
+/// All four orientations map the corners of the matrix to the right pixels.
+///
+void checkOrientations()
+{
+  const Mapping rotation0[] = {{0, 0, 0, 0}, {23, 0, 23, 0}, {0, 4, 0, 4}, {10, 3, 10, 3}};
+  checkMappings(AS1130Array::Tile24x5, AS1130Array::Rotation0, rotation0, 4, "24x5 not rotated");
+  // Clockwise: the top row of the matrix is the right column of the tile.
+  const Mapping rotation90[] = {{4, 0, 0, 0}, {4, 23, 23, 0}, {0, 0, 0, 4}, {1, 10, 10, 3}};
+  checkMappings(AS1130Array::Tile24x5, AS1130Array::Rotation90, rotation90, 4, "24x5 rotated 90");
+  const Mapping rotation180[] = {{23, 4, 0, 0}, {0, 4, 23, 0}, {23, 0, 0, 4}, {13, 1, 10, 3}};
+  checkMappings(AS1130Array::Tile24x5, AS1130Array::Rotation180, rotation180, 4, "24x5 rotated 180");
+  // Counterclockwise: the top row of the matrix is the left column of the tile.
+  const Mapping rotation270[] = {{0, 23, 0, 0}, {0, 0, 23, 0}, {4, 23, 0, 4}, {3, 13, 10, 3}};
+  checkMappings(AS1130Array::Tile24x5, AS1130Array::Rotation270, rotation270, 4, "24x5 rotated 270");
+  const Mapping matrix0[] = {{0, 0, 0, 0}, {11, 0, 11, 0}, {0, 10, 0, 10}, {7, 9, 7, 9}};
+  checkMappings(AS1130Array::Tile12x11, AS1130Array::Rotation0, matrix0, 4, "12x11 not rotated");
+  const Mapping matrix90[] = {{10, 0, 0, 0}, {10, 11, 11, 0}, {0, 0, 0, 10}, {1, 7, 7, 9}};
+  checkMappings(AS1130Array::Tile12x11, AS1130Array::Rotation90, matrix90, 4, "12x11 rotated 90");
+}
+
+
+/// Only tiles with changed pixels are uploaded.
+///
+void checkChangedTiles()
+{
+  AS1130SimulatorBus leftBus;
+  AS1130SimulatorBus rightBus;
+  AS1130SimulatedChip leftChip;
+  AS1130SimulatedChip rightChip;
+  leftBus.attachChip(leftChip);
+  rightBus.attachChip(rightChip);
+  AS1130 leftDriver(leftBus);
+  AS1130 rightDriver(rightBus);
+  uint8_t frameBuffer[6 * 5];
+  AS1130Array display(frameBuffer, 48, 5);
+  display.fill(false);
+  display.addChip(leftDriver, 0, 0, AS1130Array::Tile24x5);
+  display.addChip(rightDriver, 24, 0, AS1130Array::Tile24x5);
+  display.update();
+  check(!display.isChanged(), "no changes after the update");
+  leftBus.resetCounters();
+  rightBus.resetCounters();
+  display.setPixel(30, 2, true);
+  display.setPixel(30, 2, true);
+  display.setPixel(100, 2, true);
+  check(display.isChanged(), "pixel change marks the tile");
+  display.update();
+  check(leftBus.getTransferCount() == 0, "unchanged tile not uploaded");
+  check(rightBus.getTransferCount() == 1, "changed tile uploaded with one transfer");
+  check(isLedOn(rightChip.getOnOffFrame(0), AS1130::getLedIndex24x5(6, 2)), "pixel shown by the right chip");
+  rightBus.resetCounters();
+  frameBuffer[0] = 0x80;
+  display.markChanged(0, 0, 1, 1);
+  display.update();
+  check(leftBus.getTransferCount() == 1 && rightBus.getTransferCount() == 0, "marked tile uploaded");
+  check(isLedOn(leftChip.getOnOffFrame(0), AS1130::getLedIndex24x5(0, 0)), "direct change shown by the left chip");
+}
+
+
+/// A bus which checks that no displayed frame changes while it is visible.
+///
+class TearCheckBus : public AS1130SimulatorBus
+{
+public:
+  TearCheckBus(AS1130SimulatedChip *chips, uint8_t chipCount)
+    : _chips(chips), _chipCount(chipCount), _tearCount(0)
+  {
+    for (uint8_t i = 0; i < chipCount; ++i) {
+      attachChip(chips[i]);
+      takeSnapshot(i);
+    }
+  }
+
+  bool transfer(uint8_t chipAddress, const Message *messages, uint8_t count) override
+  {
+    const bool success = AS1130SimulatorBus::transfer(chipAddress, messages, count);
+    for (uint8_t i = 0; i < _chipCount; ++i) {
+      const uint8_t displayedFrame = _chips[i].getDisplayedFrame();
+      if (displayedFrame == _displayedFrame[i] &&
+        std::memcmp(_displayedData[i], _chips[i].getOnOffFrame(displayedFrame), sizeof(_displayedData[i])) != 0) {
+        ++_tearCount;
+      }
+      takeSnapshot(i);
+    }
+    return success;
+  }
+
+  uint32_t getTearCount() const
+  {
+    return _tearCount;
+  }
+
+private:
+  void takeSnapshot(uint8_t i)
+  {
+    _displayedFrame[i] = _chips[i].getDisplayedFrame();
+    std::memcpy(_displayedData[i], _chips[i].getOnOffFrame(_displayedFrame[i]), sizeof(_displayedData[i]));
+  }
+
+private:
+  AS1130SimulatedChip *_chips;
+  uint8_t _chipCount;
+  uint8_t _displayedFrame[3];
+  uint8_t _displayedData[3][AS1130SimulatedChip::cFrameSize];
+  uint32_t _tearCount;
+};
+
+
+/// Each flip shows the complete frame buffer on all chips without tearing.
+///
+void checkFlip()
+{
+  AS1130SimulatedChip chips[3] = {
+    AS1130SimulatedChip(AS1130::ChipAddress0),
+    AS1130SimulatedChip(AS1130::ChipAddress1),
+    AS1130SimulatedChip(AS1130::ChipAddress2)};
+  TearCheckBus bus(chips, 3);
+  AS1130 drivers[3] = {
+    AS1130(bus, AS1130::ChipAddress0),
+    AS1130(bus, AS1130::ChipAddress1),
+    AS1130(bus, AS1130::ChipAddress2)};
+  uint8_t frameBuffer[9 * 5];
+  AS1130Array display(frameBuffer, 72, 5);
+  display.fill(false);
+  for (uint8_t i = 0; i < 3; ++i) {
+    display.addChip(drivers[i], i * 24, 0, AS1130Array::Tile24x5);
+  }
+  display.setBufferFrames(2, 7);
+  uint32_t random = 1;
+  bool isComplete = true;
+  bool isSameFrame = true;
+  for (uint8_t step = 0; step < 40; ++step) {
+    // Change a few pixels, sometimes only in one tile.
+    const uint8_t changeCount = (step % 3);
+    for (uint8_t i = 0; i < changeCount; ++i) {
+      random = random * 1103515245ul + 12345ul;
+      const uint16_t x = (random >> 8) % (step % 2 == 0 ? 24 : 72);
+      const uint16_t y = (random >> 20) % 5;
+      display.setPixel(x, y, !display.getPixel(x, y));
+    }
+    const uint32_t skew = display.flip();
+    check(skew == display.getLastSkew(), "flip returns the skew");
+    const uint8_t displayedFrame = chips[0].getDisplayedFrame();
+    isSameFrame &= (displayedFrame == (step % 2 == 0 ? 7 : 2));
+    for (uint8_t i = 0; i < 3; ++i) {
+      AS1130Frame expected;
+      display.getTileFrame(i, expected);
+      isSameFrame &= (chips[i].getDisplayedFrame() == displayedFrame);
+      isComplete &= (std::memcmp(chips[i].getOnOffFrame(displayedFrame), expected.data, sizeof(expected.data)) == 0);
+    }
+  }
+  check(isSameFrame, "all chips display the same buffer frame");
+  check(isComplete, "the displayed frames contain all changes");
+  check(bus.getTearCount() == 0, "no displayed frame is changed");
+  check(display.getLastSkew() > 0, "the skew covers the writes to the other chips");
+}
+
+
+/// The synchronization settings and movie start reach all chips.
+///
+void checkSynchronization()
+{
+  AS1130SimulatedChip chips[3] = {
+    AS1130SimulatedChip(AS1130::ChipAddress0),
+    AS1130SimulatedChip(AS1130::ChipAddress1),
+    AS1130SimulatedChip(AS1130::ChipAddress2)};
+  AS1130SimulatorBus bus;
+  AS1130 drivers[3] = {
+    AS1130(bus, AS1130::ChipAddress0),
+    AS1130(bus, AS1130::ChipAddress1),
+    AS1130(bus, AS1130::ChipAddress2)};
+  uint8_t frameBuffer[3 * 15];
+  AS1130Array display(frameBuffer, 24, 15);
+  for (uint8_t i = 0; i < 3; ++i) {
+    bus.attachChip(chips[i]);
+    display.addChip(drivers[i], 0, i * 5, AS1130Array::Tile24x5);
+  }
+  display.setClockSynchronization(1, AS1130::Clock500kHz);
+  check(chips[1].getControlRegister(AS1130::CR_ClockSynchronization) == (AS1130::SynchronizationOut | AS1130::Clock500kHz), "master sends the clock");
+  check(chips[0].getControlRegister(AS1130::CR_ClockSynchronization) == (AS1130::SynchronizationIn | AS1130::Clock500kHz), "slave uses the clock");
+  check(chips[2].getControlRegister(AS1130::CR_ClockSynchronization) == (AS1130::SynchronizationIn | AS1130::Clock500kHz), "slave uses the clock");
+  for (uint8_t i = 0; i < 3; ++i) {
+    drivers[i].setMovieFrameCount(4);
+  }
+  display.startMovie(8);
+  bool isPlaying = true;
+  for (uint8_t i = 0; i < 3; ++i) {
+    isPlaying &= (chips[i].isMoviePlaying() && chips[i].getDisplayedFrame() == 8);
+  }
+  check(isPlaying, "the movie started on all chips");
+  bus.resetCounters();
+  display.startPicture(3);
+  check(bus.getMessageCount() == 3, "one message per chip for a synchronized start");
+  check(chips[2].getControlRegister(AS1130::CR_Picture) == (AS1130::PF_DisplayPicture | 3), "picture register written");
+}
+
+
+}
+
+
+int main()
+{
+  checkOrientations();
+  checkChangedTiles();
+  checkFlip();
+  checkSynchronization();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
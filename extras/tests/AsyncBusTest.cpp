@@ -0,0 +1,242 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130AsyncBus, using simulated chips.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/AsyncBusTest.cpp LRAS1130*.cpp -o async-test && ./async-test
+//
+#include "LRAS1130AsyncBus.h"
+#include "LRAS1130Discovery.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Probes are not queued and report the real answer of the chips.
+///
+void checkProbe()
+{
+  AS1130SimulatorBus simulatorBus;
+  AS1130SimulatedChip chip(AS1130::ChipAddress2);
+  simulatorBus.attachChip(chip);
+  uint8_t buffer[128];
+  AS1130AsyncBus bus(simulatorBus, buffer, sizeof(buffer));
+  AS1130 missingDriver(bus, AS1130::ChipAddress0);
+  AS1130 driver(bus, AS1130::ChipAddress2);
+  check(!missingDriver.isChipConnected(), "a missing chip is not connected");
+  check(driver.isChipConnected(), "an attached chip is connected");
+  driver.setOnOffFrameAllOn(1);
+  check(!bus.isIdle(), "writes are queued");
+  check(driver.isChipConnected(), "a probe after queued writes");
+  check(bus.isIdle() && chip.getOnOffFrame(1)[0] == 0xff, "the probe follows the queued writes");
+  check(!bus.checkFailure(), "a missing chip is no failed transfer");
+  AS1130Discovery::Result result;
+  check(AS1130Discovery::scan(bus, result) == 1, "the scan only finds the attached chip");
+  check(result.chipMask == 0x0004, "the scan finds the chip at its address");
+}
+
+
+/// The completion callback appends its context here.
+///
+uint8_t gCompletions[8];
+uint8_t gCompletionCount = 0;
+bool gCompletionSuccess = true;
+
+
+void onCompletion(bool success, void *context)
+{
+  gCompletions[gCompletionCount++] = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(context));
+  gCompletionSuccess = gCompletionSuccess && success;
+}
+
+
+/// Each call of service() sends at most one message, even for a large burst.
+///
+void checkOneMessagePerService()
+{
+  AS1130SimulatorBus simulatorBus;
+  AS1130SimulatedChip chip(AS1130::ChipAddress2);
+  simulatorBus.attachChip(chip);
+  uint8_t buffer[256];
+  AS1130AsyncBus bus(simulatorBus, buffer, sizeof(buffer));
+  AS1130 driver(bus, AS1130::ChipAddress2);
+  uint8_t values[132];
+  for (uint8_t i = 0; i < sizeof(values); ++i) {
+    values[i] = i;
+  }
+  driver.setPwmValues(3, values);
+  simulatorBus.resetCounters();
+  uint8_t callCount = 0;
+  bool isOneMessageEach = true;
+  while (!bus.isIdle() && callCount < 100) {
+    const uint32_t messageCount = simulatorBus.getMessageCount();
+    bus.service();
+    ++callCount;
+    isOneMessageEach = isOneMessageEach && (simulatorBus.getMessageCount() - messageCount == 1);
+  }
+  check(isOneMessageEach, "every service() call sends exactly one message");
+  check(callCount > 2, "the burst is split over several calls");
+  check(std::memcmp(chip.getBlinkAndPwmSet(3) + 0x18, values, sizeof(values)) == 0, "the split burst writes all values");
+  check(!bus.checkFailure(), "no failure for a split burst");
+}
+
+
+/// Completions are called in order, directly after the last message before them.
+///
+void checkOrder()
+{
+  AS1130SimulatorBus simulatorBus;
+  AS1130SimulatedChip chip(AS1130::ChipAddress2);
+  simulatorBus.attachChip(chip);
+  uint8_t buffer[256];
+  AS1130AsyncBus bus(simulatorBus, buffer, sizeof(buffer));
+  AS1130 driver(bus, AS1130::ChipAddress2);
+  gCompletionCount = 0;
+  gCompletionSuccess = true;
+  bus.addCompletion(onCompletion, reinterpret_cast<void*>(0));
+  driver.setOnOffFrameAllOn(1);
+  bus.addCompletion(onCompletion, reinterpret_cast<void*>(1));
+  bus.addCompletion(onCompletion, reinterpret_cast<void*>(2));
+  check(gCompletionCount == 0, "completions wait for service()");
+  while (bus.service()) {
+  }
+  check(gCompletionCount == 3, "all completions are called");
+  check(gCompletions[0] == 0 && gCompletions[1] == 1 && gCompletions[2] == 2, "completions are called in order");
+  check(gCompletionSuccess, "completions report success");
+  check(chip.getOnOffFrame(1)[0] == 0xff, "the frame is written");
+}
+
+
+/// Many small writes wrap around a small ring buffer without losing data.
+///
+void checkWrapAround()
+{
+  AS1130SimulatorBus simulatorBus;
+  AS1130SimulatedChip chip(AS1130::ChipAddress2);
+  simulatorBus.attachChip(chip);
+  uint8_t buffer[100];
+  AS1130AsyncBus bus(simulatorBus, buffer, sizeof(buffer));
+  AS1130 driver(bus, AS1130::ChipAddress2);
+  AS1130Frame frame;
+  bool isBufferInUse = true;
+  for (uint8_t round = 0; round < 20; ++round) {
+    for (uint8_t frameIndex = 0; frameIndex < 4; ++frameIndex) {
+      std::memset(frame.data, round, sizeof(frame.data));
+      frame.data[0] = frameIndex;
+      driver.setOnOffFrame(frameIndex + 1, frame);
+      isBufferInUse = isBufferInUse && bus.getQueuedByteCount() < sizeof(buffer);
+      bus.service(round % 3);
+    }
+  }
+  check(isBufferInUse, "the queue fits into the buffer");
+  bus.flush();
+  check(bus.isIdle(), "the queue is empty after a flush");
+  for (uint8_t frameIndex = 0; frameIndex < 4; ++frameIndex) {
+    const uint8_t *data = chip.getOnOffFrame(frameIndex + 1);
+    check(data[0] == frameIndex && data[23] == 19, "the last write of each frame is on the chip");
+  }
+  check(!bus.checkFailure(), "no failure after wrapping");
+}
+
+
+/// A failed message skips the rest of its transfer and is reported.
+///
+void checkFailure()
+{
+  AS1130SimulatorBus simulatorBus(8);
+  AS1130SimulatedChip chip(AS1130::ChipAddress2);
+  simulatorBus.attachChip(chip);
+  uint8_t buffer[256];
+  AS1130AsyncBus bus(simulatorBus, buffer, sizeof(buffer));
+  AS1130 driver(bus, AS1130::ChipAddress2);
+  gCompletionCount = 0;
+  gCompletionSuccess = true;
+  driver.setOnOffFrameAllOn(1);
+  bus.addCompletion(onCompletion, reinterpret_cast<void*>(0));
+  bus.service();
+  bus.service();
+  chip.setConnected(false);
+  simulatorBus.resetCounters();
+  bus.service();
+  chip.setConnected(true);
+  check(bus.isIdle() && gCompletionCount == 1, "the rest of the failed transfer is skipped");
+  check(simulatorBus.getMessageCount() == 1, "only the failed message is sent");
+  check(!gCompletionSuccess, "the completion reports the failure");
+  check(bus.checkFailure(), "the failure is flagged");
+  check(bus.getFailedTransferCount() == 1, "the failure is counted once");
+}
+
+
+/// A read sends all queued messages first.
+///
+void checkReadFlushes()
+{
+  AS1130SimulatorBus simulatorBus;
+  AS1130SimulatedChip chip(AS1130::ChipAddress2);
+  simulatorBus.attachChip(chip);
+  uint8_t buffer[256];
+  AS1130AsyncBus bus(simulatorBus, buffer, sizeof(buffer));
+  AS1130 driver(bus, AS1130::ChipAddress2);
+  driver.setOnOffFrameAllOn(1);
+  bus.service();
+  check(!bus.isIdle(), "the transfer is partly sent");
+  driver.getInterruptStatus();
+  check(bus.isIdle(), "a read flushes the queue");
+  check(chip.getOnOffFrame(1)[23] != 0, "the flushed frame is complete");
+}
+
+
+}
+
+
+int main()
+{
+  checkProbe();
+  checkOneMessagePerService();
+  checkOrder();
+  checkWrapAround();
+  checkFailure();
+  checkReadFlushes();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
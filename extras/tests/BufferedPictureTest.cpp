@@ -0,0 +1,125 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130BufferedPicture, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/BufferedPictureTest.cpp LRAS1130*.cpp -o buffered-test && ./buffered-test
+//
+#include "LRAS1130BufferedPicture.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// A bus which checks that the displayed frame never changes while it is visible.
+///
+class TearCheckBus : public AS1130SimulatorBus
+{
+public:
+  explicit TearCheckBus(AS1130SimulatedChip &chip)
+    : _chip(chip), _displayedFrame(0), _tearCount(0)
+  {
+    attachChip(chip);
+    std::memcpy(_displayedData, chip.getOnOffFrame(0), sizeof(_displayedData));
+  }
+
+  bool transfer(uint8_t chipAddress, const Message *messages, uint8_t count) override
+  {
+    const bool success = AS1130SimulatorBus::transfer(chipAddress, messages, count);
+    const uint8_t displayedFrame = _chip.getDisplayedFrame();
+    if (displayedFrame == _displayedFrame && std::memcmp(_displayedData, _chip.getOnOffFrame(displayedFrame), sizeof(_displayedData)) != 0) {
+      ++_tearCount;
+    }
+    _displayedFrame = displayedFrame;
+    std::memcpy(_displayedData, _chip.getOnOffFrame(displayedFrame), sizeof(_displayedData));
+    return success;
+  }
+
+  uint32_t getTearCount() const
+  {
+    return _tearCount;
+  }
+
+private:
+  AS1130SimulatedChip &_chip;
+  uint8_t _displayedFrame;
+  uint8_t _displayedData[AS1130SimulatedChip::cFrameSize];
+  uint32_t _tearCount;
+};
+
+
+/// Each picture is written to a hidden frame and then displayed.
+///
+void checkFlip(uint8_t frameCount)
+{
+  AS1130SimulatedChip chip;
+  TearCheckBus bus(chip);
+  AS1130 driver(bus);
+  AS1130BufferedPicture picture(driver, 4, frameCount);
+  check(picture.getDisplayedFrameIndex() == 4, "first frame before the first picture");
+  uint8_t bitmap[15];
+  uint8_t expected[AS1130SimulatedChip::cFrameSize];
+  for (uint8_t step = 0; step < 7; ++step) {
+    std::memset(bitmap, step * 0x11, sizeof(bitmap));
+    picture.show24x5(bitmap, 2);
+    const uint8_t frameIndex = 4 + ((step + 1) % (frameCount < 2 ? 2 : frameCount));
+    check(picture.getDisplayedFrameIndex() == frameIndex, "frames are used in turn");
+    check(chip.getDisplayedFrame() == frameIndex, "the chip displays the new frame");
+    AS1130::encodeFrame24x5(bitmap, expected, 2);
+    check(std::memcmp(chip.getOnOffFrame(frameIndex), expected, sizeof(expected)) == 0, "the displayed frame shows the picture");
+  }
+  check(bus.getTearCount() == 0, "the displayed frame is never changed");
+}
+
+
+}
+
+
+int main()
+{
+  checkFlip(1);
+  checkFlip(2);
+  checkFlip(3);
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
@@ -0,0 +1,124 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for the control register shadow copy of AS1130, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/ControlRegisterShadowTest.cpp LRAS1130*.cpp -o shadow-test && ./shadow-test
+//
+#include "LRAS1130.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Enabling the shadow reads the registers once, bit changes need no reads.
+///
+void checkNoReads()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.writeControlRegister(AS1130::CR_Config, AS1130::RamConfiguration3);
+  driver.setControlRegisterShadowEnabled(true);
+  bus.resetCounters();
+  driver.setLowVddResetEnabled(true);
+  driver.setDotCorrectionEnabled(true);
+  driver.setBlinkEnabled(false);
+  driver.setScanLimit(AS1130::ScanLimit7);
+  driver.setLowVddResetEnabled(false);
+  check(bus.getBytesRead() == 0, "no reads with the shadow enabled");
+  check(chip.getControlRegister(AS1130::CR_Config) == (AS1130::RamConfiguration3 | AS1130::CF_DotCorrection), "config register matches the chip");
+  check((chip.getControlRegister(AS1130::CR_DisplayOption) & 0x0f) == AS1130::ScanLimit7, "scan limit written");
+  driver.setControlRegisterShadowEnabled(false);
+  bus.resetCounters();
+  driver.setLowVddResetEnabled(true);
+  check(bus.getBytesRead() == 1, "a read for each change with the shadow disabled");
+}
+
+
+/// A failed write leaves the shadow unchanged.
+///
+void checkFailedWrite()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.setControlRegisterShadowEnabled(true);
+  chip.setConnected(false);
+  driver.setLowVddResetEnabled(true);
+  chip.setConnected(true);
+  driver.setDotCorrectionEnabled(true);
+  check(chip.getControlRegister(AS1130::CR_Config) == AS1130::CF_DotCorrection, "the failed change is not in the shadow");
+}
+
+
+/// Writes through the low-level functions update the shadow.
+///
+void checkBlockWrite()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.setControlRegisterShadowEnabled(true);
+  const uint8_t registers[] = {0x00, 0x00, 0x00, 0x00, 0xeb, 0x55, 0x00};
+  driver.writeMemoryBlock(AS1130::RS_Control, AS1130::CR_Picture, registers, sizeof(registers));
+  driver.fillMemoryBlock(AS1130::RS_Control, AS1130::CR_InterruptMask, 0x00, 5);
+  driver.setScanLimit(AS1130::ScanLimit1);
+  check(chip.getControlRegister(AS1130::CR_DisplayOption) == 0xe0, "block write updated the shadow");
+  check(chip.getControlRegister(AS1130::CR_CurrentSource) == 0x55, "current source unchanged");
+}
+
+
+}
+
+
+int main()
+{
+  checkNoReads();
+  checkFailedWrite();
+  checkBlockWrite();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
@@ -0,0 +1,122 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130Discovery, using simulated chips.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/DiscoveryTest.cpp LRAS1130*.cpp -o discovery-test && ./discovery-test
+//
+#include "LRAS1130Discovery.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Only connected chips are found, the probe keeps the register selection.
+///
+void checkScan()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip0(AS1130::ChipAddress0);
+  AS1130SimulatedChip chip5(AS1130::ChipAddress5);
+  AS1130SimulatedChip chip9(AS1130::ChipAddress9);
+  AS1130SimulatedChip chipF(AS1130::ChipAddressF);
+  bus.attachChip(chip0);
+  bus.attachChip(chip5);
+  bus.attachChip(chip9);
+  bus.attachChip(chipF);
+  chip9.setConnected(false);
+  AS1130 driver(bus, AS1130::ChipAddress5);
+  driver.writeToMemory(AS1130::RS_OnOffFrame + 1, 0, 0x01);
+  AS1130Discovery::Result result;
+  bus.resetCounters();
+  check(AS1130Discovery::scan(bus, result) == 3, "three chips found");
+  check(bus.getTransferCount() == AS1130Discovery::cChipAddressCount, "one transfer for each address");
+  check(result.chipMask == 0x8021, "chip mask");
+  check(result.isChipFound(AS1130::ChipAddress5) && !result.isChipFound(AS1130::ChipAddress9), "found chips");
+  check(result.getConfiguration(AS1130::ChipAddress5) == nullptr, "no configuration without reading it");
+  check(chip5.getRegisterSelection() == AS1130::RS_OnOffFrame + 1, "the probe keeps the register selection");
+  driver.writeToMemory(AS1130::RS_OnOffFrame + 1, 1, 0x02);
+  check(chip5.getOnOffFrame(1)[1] == 0x02, "the driver continues with its cached selection");
+}
+
+
+/// Reading the configuration returns the control registers and invalidates the drivers.
+///
+void checkConfiguration()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip2(AS1130::ChipAddress2);
+  AS1130SimulatedChip chip3(AS1130::ChipAddress3);
+  bus.attachChip(chip2);
+  bus.attachChip(chip3);
+  AS1130 driver2(bus, AS1130::ChipAddress2);
+  AS1130 driver3(bus, AS1130::ChipAddress3);
+  driver2.setRamConfiguration(AS1130::RamConfiguration4);
+  driver3.setCurrentSource(AS1130::Current15mA);
+  driver2.writeToMemory(AS1130::RS_OnOffFrame, 0, 0x00);
+  driver3.writeToMemory(AS1130::RS_OnOffFrame, 0, 0x00);
+  AS1130 *const drivers[] = {&driver2, &driver3};
+  AS1130Discovery::Result result;
+  check(AS1130Discovery::scan(bus, result, true, drivers, 2) == 2, "two chips found");
+  const uint8_t *configuration = result.getConfiguration(AS1130::ChipAddress2);
+  check(configuration != nullptr && configuration[AS1130::CR_Config] == AS1130::RamConfiguration4, "configuration of the first chip");
+  configuration = result.getConfiguration(AS1130::ChipAddress3);
+  check(configuration != nullptr && configuration[AS1130::CR_CurrentSource] == AS1130::Current15mA, "configuration of the second chip");
+  check(result.getConfiguration(AS1130::ChipAddress4) == nullptr, "no configuration for a missing chip");
+  driver2.writeToMemory(AS1130::RS_OnOffFrame, 0, 0xaa);
+  driver3.writeToMemory(AS1130::RS_OnOffFrame, 0, 0xbb);
+  check(chip2.getOnOffFrame(0)[0] == 0xaa && chip3.getOnOffFrame(0)[0] == 0xbb, "the drivers select the frame again");
+  check(chip2.getControlRegister(AS1130::CR_CurrentSource) == 0 && chip3.getControlRegister(AS1130::CR_CurrentSource) == AS1130::Current15mA,
+    "the control registers are unchanged");
+}
+
+
+}
+
+
+int main()
+{
+  checkScan();
+  checkConfiguration();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
@@ -0,0 +1,123 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130GrayscalePacker, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/GrayscalePackerTest.cpp LRAS1130*.cpp -o packer-test && ./packer-test
+//
+#include "LRAS1130GrayscalePacker.h"
+#include "LRAS1130RamAllocator.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    if (gFailureCount == 0) {
+      std::printf("FAILED: %s\n", message);
+    }
+    ++gFailureCount;
+  }
+}
+
+
+/// Pack frames with a uniform brightness each, and check the result on the simulated chip.
+///
+void checkUniformFrames(const uint8_t *levels, uint8_t frameCount, uint8_t firstFrameIndex, const char *name)
+{
+  static uint8_t frames[36][120];
+  for (uint8_t frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+    std::memset(frames[frameIndex], levels[frameIndex], 120);
+  }
+  AS1130GrayscalePacker packer(AS1130GrayscalePacker::Layout24x5, 256);
+  check(packer.pack(&frames[0][0], frameCount, firstFrameIndex), name);
+  const uint8_t configFrameCount = AS1130RamAllocator::getFrameCount(packer.getRamConfiguration(), false);
+  check(firstFrameIndex + frameCount <= configFrameCount, name);
+  // Distinct non-blank levels need distinct sets.
+  for (uint8_t a = 0; a < frameCount; ++a) {
+    for (uint8_t b = a + 1; b < frameCount; ++b) {
+      if (levels[a] != 0 && levels[b] != 0 && levels[a] != levels[b]) {
+        check(packer.getFramePwmSetIndex(a) != packer.getFramePwmSetIndex(b), name);
+      }
+    }
+  }
+  AS1130SimulatorBus bus(255);
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  packer.upload(driver);
+  check((chip.getControlRegister(AS1130::CR_Config) & AS1130::CF_MemoryConfigMask) == packer.getRamConfiguration(), name);
+  for (uint8_t frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+    const uint8_t *frame = chip.getOnOffFrame(firstFrameIndex + frameIndex);
+    const uint8_t *set = chip.getBlinkAndPwmSet(frame[1] >> 5);
+    for (uint8_t y = 0; y < 5; ++y) {
+      for (uint8_t x = 0; x < 24; ++x) {
+        const uint8_t ledIndex = AS1130::getLedIndex24x5(x, y);
+        const uint8_t led = ledIndex & 0x0f;
+        const bool isOn = (frame[((ledIndex >> 4) << 1) + (led >> 3)] & (1 << (led & 0x07))) != 0;
+        check(isOn == (levels[frameIndex] != 0), name);
+        if (isOn) {
+          check(set[AS1130::getPwmAddress(ledIndex)] == levels[frameIndex], name);
+        }
+      }
+    }
+  }
+}
+
+
+}
+
+
+int main()
+{
+  const uint8_t blankFirst[] = {0, 255, 16};
+  checkUniformFrames(blankFirst, 3, 0, "blank first frame");
+  // Ten frames use RAM configuration 5 with five sets.
+  const uint8_t fiveLevels[] = {0, 0, 10, 40, 80, 200, 255, 10, 255, 0};
+  checkUniformFrames(fiveLevels, 10, 0, "five levels with blank frames");
+  // Six frames at frame 10 need RAM configuration 4 with four sets, not 6.
+  const uint8_t fourLevels[] = {20, 40, 0, 60, 80, 40};
+  checkUniformFrames(fourLevels, 6, 10, "frames after the start of the memory");
+  // Six frames at frame 30 need RAM configuration 1 with one set.
+  const uint8_t oneLevel[] = {0, 90, 90, 0, 90, 90};
+  checkUniformFrames(oneLevel, 6, 30, "frames at the end of the memory");
+  static uint8_t frames[6][120];
+  AS1130GrayscalePacker packer(AS1130GrayscalePacker::Layout24x5);
+  check(!packer.pack(&frames[0][0], 6, 31), "frames beyond the memory are rejected");
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
+
@@ -0,0 +1,150 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for the diff-based writes of AS1130 with a memory cache, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/MemoryCacheTest.cpp LRAS1130*.cpp -o cache-test && ./cache-test
+//
+#include "LRAS1130.h"
+#include "LRAS1130MemoryCache.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Only changed bytes are sent, small gaps are merged into one message.
+///
+void checkChangedBytes()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130MemoryCache cache;
+  driver.setMemoryCache(&cache);
+  uint8_t frame[0x18];
+  for (uint8_t i = 0; i < sizeof(frame); ++i) {
+    frame[i] = i;
+  }
+  driver.writeMemoryBlock(AS1130::RS_OnOffFrame, 0, frame, sizeof(frame));
+  check(std::memcmp(chip.getOnOffFrame(0), frame, sizeof(frame)) == 0, "first write complete");
+  bus.resetCounters();
+  driver.writeMemoryBlock(AS1130::RS_OnOffFrame, 0, frame, sizeof(frame));
+  check(bus.getTransferCount() == 0, "unchanged frame is not sent");
+  frame[4] = 0xaa;
+  driver.writeMemoryBlock(AS1130::RS_OnOffFrame, 0, frame, sizeof(frame));
+  check(bus.getMessageCount() == 1 && bus.getBytesWritten() == 2, "a single changed byte");
+  bus.resetCounters();
+  frame[10] = 0xaa;
+  frame[12] = 0xaa;
+  driver.writeMemoryBlock(AS1130::RS_OnOffFrame, 0, frame, sizeof(frame));
+  check(bus.getMessageCount() == 1 && bus.getBytesWritten() == 4, "a small gap is merged");
+  bus.resetCounters();
+  frame[0] = 0xaa;
+  frame[20] = 0xaa;
+  driver.writeMemoryBlock(AS1130::RS_OnOffFrame, 0, frame, sizeof(frame));
+  check(bus.getMessageCount() == 2 && bus.getBytesWritten() == 4, "a large gap splits the message");
+  check(std::memcmp(chip.getOnOffFrame(0), frame, sizeof(frame)) == 0, "chip matches the frame");
+}
+
+
+/// Fill writes only use the fill buffer, even on a bus with longer messages.
+///
+void checkFill()
+{
+  AS1130SimulatorBus bus(255);
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130MemoryCache cache;
+  driver.setMemoryCache(&cache);
+  driver.setBlinkAndPwmSetAll(1, false, 0x80);
+  bool isFilled = true;
+  for (uint8_t i = 0x18; i < AS1130SimulatedChip::cBlinkAndPwmSetSize; ++i) {
+    isFilled &= (chip.getBlinkAndPwmSet(1)[i] == 0x80);
+  }
+  check(isFilled, "set filled with the PWM value");
+  bus.resetCounters();
+  driver.setBlinkAndPwmSetAll(1, false, 0x80);
+  check(bus.getTransferCount() == 0, "unchanged set is not sent");
+  driver.fillMemoryBlock(AS1130::RS_BlinkAndPwmSet + 1, 0x20, 0x10, 0x40);
+  check(bus.getMessageCount() == 2, "fill split at the size of the fill buffer");
+  check(chip.getBlinkAndPwmSet(1)[0x5f] == 0x10 && chip.getBlinkAndPwmSet(1)[0x60] == 0x80, "fill range written");
+}
+
+
+/// A failed write leaves the cache unsure about the chip content.
+///
+void checkFailedWrite()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130MemoryCache cache;
+  driver.setMemoryCache(&cache);
+  driver.setOnOffFrameAllOn(3);
+  chip.setConnected(false);
+  driver.fillMemoryBlock(AS1130::RS_OnOffFrame + 3, 0, 0x00, 0x18);
+  chip.setConnected(true);
+  driver.fillMemoryBlock(AS1130::RS_OnOffFrame + 3, 0, 0x00, 0x18);
+  check(chip.getOnOffFrame(3)[0] == 0x00, "failed write is sent again");
+  driver.setOnOffFrameAllOn(3);
+  chip.powerOnReset();
+  driver.getInterruptStatus();
+  driver.setOnOffFrameAllOn(3);
+  check(chip.getOnOffFrame(3)[0] == 0xff, "frame written again after a power on reset");
+}
+
+
+}
+
+
+int main()
+{
+  checkChangedBytes();
+  checkFill();
+  checkFailedWrite();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
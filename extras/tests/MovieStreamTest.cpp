@@ -0,0 +1,194 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130MovieStream, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/MovieStreamTest.cpp LRAS1130*.cpp -o stream-test && ./stream-test
+//
+#include "LRAS1130MovieStream.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Push a frame where all LEDs show the bits of the given number.
+///
+bool pushNumber(AS1130MovieStream &stream, uint8_t number)
+{
+  uint8_t bitmap[15];
+  std::memset(bitmap, number, sizeof(bitmap));
+  return stream.pushFrame24x5(bitmap);
+}
+
+
+/// Get the number shown in the displayed frame of the chip.
+///
+int16_t getDisplayedNumber(const AS1130SimulatedChip &chip)
+{
+  const uint8_t *frame = chip.getOnOffFrame(chip.getDisplayedFrame());
+  uint8_t bitmap[15];
+  uint8_t expected[AS1130SimulatedChip::cFrameSize];
+  for (uint16_t number = 0; number < 0x100; ++number) {
+    std::memset(bitmap, number, sizeof(bitmap));
+    AS1130::encodeFrame24x5(bitmap, expected);
+    if (std::memcmp(frame, expected, sizeof(expected)) == 0) {
+      return number;
+    }
+  }
+  return -1;
+}
+
+
+/// Prepare a chip playing a movie with a 65ms frame delay.
+///
+void startMovie(AS1130 &driver, AS1130MovieStream &stream, uint8_t &nextNumber)
+{
+  while (pushNumber(stream, nextNumber)) {
+    ++nextNumber;
+  }
+  driver.setFrameDelayMs(65);
+  stream.start();
+  driver.startChip();
+}
+
+
+/// A stream updated in time shows all frames in order.
+///
+void checkContinuousPlay()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130MovieStream stream(driver, 2, 6);
+  uint8_t nextNumber = 0;
+  startMovie(driver, stream, nextNumber);
+  check(nextNumber == 6, "the ring buffer is filled");
+  check(getDisplayedNumber(chip) == 0, "the movie starts with the first frame");
+  int16_t lastNumber = 0;
+  bool isInOrder = true;
+  for (uint16_t step = 0; step < 400; ++step) {
+    bus.advanceTime(5000);
+    stream.update();
+    while (stream.getFreeFrameCount() > 0) {
+      pushNumber(stream, nextNumber++);
+    }
+    const int16_t number = getDisplayedNumber(chip);
+    isInOrder &= (number == lastNumber || number == lastNumber + 1);
+    lastNumber = number;
+  }
+  check(isInOrder, "frames are shown in order without gaps");
+  check(lastNumber > 20, "the movie advanced beyond the ring buffer");
+  check(!stream.checkUnderrun(), "no underrun");
+  check(stream.getPlayedFrameCount() == static_cast<uint32_t>(lastNumber), "played frames counted");
+}
+
+
+/// Missing updates are reported as underrun, the stream recovers.
+///
+void checkUnderrun()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130MovieStream stream(driver, 0, 4);
+  uint8_t nextNumber = 0;
+  startMovie(driver, stream, nextNumber);
+  bus.advanceTime(200000);
+  stream.update();
+  check(!stream.checkUnderrun(), "no underrun while queued frames are played");
+  check(stream.getFreeFrameCount() == 3, "played frames are free");
+  bus.advanceTime(65000);
+  stream.update();
+  check(stream.checkUnderrun(), "underrun reported");
+  check(!stream.checkUnderrun(), "underrun flag cleared");
+  check(stream.getFreeFrameCount() == 3, "all frames but the displayed one are free");
+  const uint8_t displayedFrame = chip.getDisplayedFrame();
+  pushNumber(stream, 100);
+  bus.advanceTime(65000);
+  check(chip.getDisplayedFrame() == (displayedFrame + 1) % 4, "the chip moved to the next frame");
+  check(getDisplayedNumber(chip) == 100, "the next pushed frame follows the displayed one");
+}
+
+
+/// After stop(), the stream starts again at the first frame.
+///
+void checkRestart()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130MovieStream stream(driver, 10, 5);
+  uint8_t nextNumber = 0;
+  startMovie(driver, stream, nextNumber);
+  for (uint8_t step = 0; step < 3; ++step) {
+    bus.advanceTime(65000);
+    stream.update();
+    pushNumber(stream, nextNumber++);
+  }
+  stream.stop();
+  check(stream.getFreeFrameCount() == 5, "stop discards the queue");
+  nextNumber = 50;
+  startMovie(driver, stream, nextNumber);
+  check(chip.getDisplayedFrame() == 10, "restart at the first frame");
+  check(getDisplayedNumber(chip) == 50, "restart shows the first pushed frame");
+  bus.advanceTime(65000);
+  stream.update();
+  check(getDisplayedNumber(chip) == 51, "restart continues in order");
+  check(stream.getPlayedFrameCount() == 1, "played frames counted from the restart");
+}
+
+
+}
+
+
+int main()
+{
+  checkContinuousPlay();
+  checkUnderrun();
+  checkRestart();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
@@ -0,0 +1,165 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130PictureCache, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/PictureCacheTest.cpp LRAS1130*.cpp -o picture-cache-test && ./picture-cache-test
+//
+#include "LRAS1130PictureCache.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Create a picture where all LEDs show the bits of the given number.
+///
+AS1130Frame getPicture(uint8_t number)
+{
+  uint8_t bitmap[15];
+  std::memset(bitmap, number, sizeof(bitmap));
+  AS1130Frame frame;
+  AS1130::encodeFrame24x5(bitmap, frame.data);
+  return frame;
+}
+
+
+/// Check that the chip displays the given picture.
+///
+bool isDisplayed(const AS1130SimulatedChip &chip, uint8_t number)
+{
+  const AS1130Frame frame = getPicture(number);
+  return std::memcmp(chip.getOnOffFrame(chip.getDisplayedFrame()), frame.data, sizeof(frame.data)) == 0;
+}
+
+
+/// Cached pictures only change the picture register.
+///
+void checkHits()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130PictureCache::Slot slots[3];
+  AS1130PictureCache cache(driver, 5, slots, 3);
+  check(!cache.show(getPicture(1)), "first picture is a miss");
+  check(!cache.show(getPicture(2)), "second picture is a miss");
+  bus.resetCounters();
+  check(cache.show(getPicture(1)), "repeated picture is a hit");
+  check(bus.getTransferCount() == 1, "a hit only writes the picture register");
+  check(isDisplayed(chip, 1), "hit displayed");
+  check(cache.getDisplayedFrameIndex() == 5, "hit uses the cached frame");
+  uint8_t bitmap[15];
+  std::memset(bitmap, 2, sizeof(bitmap));
+  check(cache.show24x5(bitmap), "bitmap of a cached picture is a hit");
+  check(isDisplayed(chip, 2), "bitmap hit displayed");
+  cache.invalidate();
+  check(!cache.show(getPicture(2)), "no hit after invalidate");
+  check(isDisplayed(chip, 2), "picture written again after invalidate");
+}
+
+
+/// The least recently used picture is replaced, never the displayed one.
+///
+void checkReplacement()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130PictureCache::Slot slots[3];
+  AS1130PictureCache cache(driver, 0, slots, 3);
+  cache.show(getPicture(1));
+  cache.show(getPicture(2));
+  cache.show(getPicture(3));
+  cache.show(getPicture(1));
+  check(!cache.show(getPicture(4)), "new picture is a miss");
+  check(cache.show(getPicture(1)), "recently used picture is kept");
+  check(cache.show(getPicture(3)), "recently used picture is kept");
+  check(!cache.show(getPicture(2)), "least recently used picture was replaced");
+  check(isDisplayed(chip, 2), "replaced picture displayed");
+  // Many hits overflow the use counter, the order has to be kept.
+  for (uint32_t i = 0; i < 0x18000; ++i) {
+    cache.show(getPicture(static_cast<uint8_t>(1 + (i % 2) * 2)));
+  }
+  check(cache.show(getPicture(1)), "picture kept after the counter overflow");
+  check(!cache.show(getPicture(5)), "new picture after the counter overflow");
+  check(cache.show(getPicture(3)), "picture kept after the counter overflow");
+  check(!cache.show(getPicture(6)), "new picture replaces the least recently used one");
+  check(cache.show(getPicture(5)) && cache.show(getPicture(3)), "recently used pictures kept after the counter overflow");
+  check(!cache.show(getPicture(1)), "least recently used picture replaced after the counter overflow");
+}
+
+
+/// Pictures which only differ in a few bits are never confused.
+///
+void checkSimilarPictures()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  AS1130PictureCache::Slot slots[AS1130PictureCache::cMaximumFrameCount];
+  AS1130PictureCache cache(driver, 0, slots, AS1130PictureCache::cMaximumFrameCount);
+  bool isCorrect = true;
+  for (uint16_t number = 0; number < 0x100; ++number) {
+    cache.show(getPicture(static_cast<uint8_t>(number)));
+    isCorrect &= isDisplayed(chip, static_cast<uint8_t>(number));
+    cache.show(getPicture(static_cast<uint8_t>(number / 2)));
+    isCorrect &= isDisplayed(chip, static_cast<uint8_t>(number / 2));
+  }
+  check(isCorrect, "each picture is displayed as requested");
+}
+
+
+}
+
+
+int main()
+{
+  checkHits();
+  checkReplacement();
+  checkSimilarPictures();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
@@ -0,0 +1,121 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130RamAllocator.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/RamAllocatorTest.cpp LRAS1130*.cpp -o allocator-test && ./allocator-test
+//
+#include "LRAS1130RamAllocator.h"
+
+#include <cstdio>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// The frame and set counts follow the RAM configurations of the chip.
+///
+void checkConfigurations()
+{
+  for (uint8_t config = 1; config <= 6; ++config) {
+    const AS1130::RamConfiguration ramConfiguration = static_cast<AS1130::RamConfiguration>(config);
+    check(AS1130RamAllocator::getFrameCount(ramConfiguration, false) == 42 - config * 6, "frame count");
+    check(AS1130RamAllocator::getFrameCount(ramConfiguration, true) == 41 - config * 6, "frame count with dot correction");
+    check(AS1130RamAllocator::getPwmSetCount(ramConfiguration) == config, "set count");
+  }
+  AS1130RamAllocator ram(AS1130::RamConfiguration5, true);
+  check(ram.getFrameCount() == 11 && ram.getFreeFrameCount() == 11, "all frames free");
+  check(ram.isFrameAllocated(11) && ram.isFrameAllocated(35), "frames outside the configuration");
+  check(ram.isPwmSetAllocated(5), "sets outside the configuration");
+  check(ram.allocateFrames(12) == -1, "a range larger than the memory");
+  check(ram.allocateFrames(11) == 0, "a range of all frames");
+  check(ram.allocateFrame() == -1, "no frame left");
+}
+
+
+/// Frames are taken from the smallest range which fits.
+///
+void checkBestFit()
+{
+  AS1130RamAllocator ram(AS1130::RamConfiguration3);
+  check(ram.allocateFrames(4) == 0, "first range");
+  check(ram.allocateFrames(2) == 4, "second range");
+  check(ram.allocateFrames(6) == 6, "third range");
+  ram.freeFrames(4, 2);
+  check(ram.getLargestFreeFrameRange() == 12, "largest range at the end");
+  check(ram.getFragmentation() == 15, "two of 14 free frames outside the largest range");
+  check(ram.allocateFrame() == 4, "a single frame fills the small gap");
+  check(ram.allocateFrames(3) == 12, "a range which does not fit the gap");
+  check(ram.allocateFrame() == 5, "the rest of the small gap");
+  check(ram.getFragmentation() == 0, "no fragmentation");
+  ram.freeFrame(0);
+  ram.freeFrame(2);
+  check(ram.allocateFrames(2) == 15, "separate single frames do not form a range");
+  check(ram.getFreeFrameCount() == 9, "free frames counted");
+  ram.reset(AS1130::RamConfiguration3);
+  check(ram.getFreeFrameCount() == 24 && ram.getFragmentation() == 0, "reset frees all frames");
+}
+
+
+/// Sets are handed out once until they are freed.
+///
+void checkPwmSets()
+{
+  AS1130RamAllocator ram(AS1130::RamConfiguration2);
+  check(ram.allocatePwmSet() == 0, "first set");
+  check(ram.allocatePwmSet() == 1, "second set");
+  check(ram.allocatePwmSet() == -1, "no set left");
+  check(ram.getFreePwmSetCount() == 0, "no free set");
+  ram.freePwmSet(0);
+  check(!ram.isPwmSetAllocated(0) && ram.isPwmSetAllocated(1), "set freed");
+  check(ram.allocatePwmSet() == 0, "freed set reused");
+}
+
+
+}
+
+
+int main()
+{
+  checkConfigurations();
+  checkBestFit();
+  checkPwmSets();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
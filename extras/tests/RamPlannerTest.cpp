@@ -0,0 +1,148 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for AS1130RamPlanner, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/RamPlannerTest.cpp LRAS1130*.cpp -o planner-test && ./planner-test
+//
+#include "LRAS1130RamPlanner.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Check that the resident content does not overlap and fits the configuration.
+///
+void checkLayout(const AS1130RamPlanner &planner, const uint8_t *frameCounts, uint8_t animationCount,
+  uint8_t pictureCount, bool isDotCorrectionUsed, const char *name)
+{
+  const uint8_t frameCount = AS1130RamAllocator::getFrameCount(planner.getRamConfiguration(), isDotCorrectionUsed);
+  bool isUsed[36] = {};
+  bool isValid = true;
+  uint8_t nonResidentCount = 0;
+  for (uint8_t i = 0; i < animationCount + pictureCount; ++i) {
+    const bool isAnimation = (i < animationCount);
+    const int8_t firstFrame = (isAnimation ? planner.getAnimationFrameIndex(i) : planner.getPictureFrameIndex(i - animationCount));
+    if (firstFrame < 0) {
+      ++nonResidentCount;
+      continue;
+    }
+    const uint8_t count = (isAnimation ? frameCounts[i] : 1);
+    for (uint8_t frame = firstFrame; frame < firstFrame + count; ++frame) {
+      isValid &= (frame < frameCount && !isUsed[frame]);
+      if (frame < 36) {
+        isUsed[frame] = true;
+      }
+    }
+  }
+  check(isValid, name);
+  check(nonResidentCount <= planner.getNonResidentCount(), name);
+}
+
+
+/// Content which fits is resident, with the configuration that leaves the most frames.
+///
+void checkResident()
+{
+  const uint8_t frameCounts[] = {12, 8};
+  AS1130RamPlanner planner(true);
+  planner.setAnimations(frameCounts, 2);
+  planner.setPictureCount(4);
+  planner.setPwmSetCount(2);
+  check(planner.plan(), "all content resident");
+  check(planner.getRamConfiguration() == AS1130::RamConfiguration2, "configuration with two sets");
+  check(planner.getNonResidentCount() == 0, "nothing to upload at runtime");
+  check(planner.getPwmSetIndex(1) == 1 && planner.getPwmSetIndex(2) == -1, "sets mapped");
+  checkLayout(planner, frameCounts, 2, 4, true, "resident layout");
+  check(planner.getAllocator().getFreeFrameCount() == 5, "remaining frames available at runtime");
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  planner.apply(driver);
+  check(chip.getControlRegister(AS1130::CR_Config) == (AS1130::RamConfiguration2 | AS1130::CF_DotCorrection), "configuration written to the chip");
+}
+
+
+/// Many sets select a configuration with few frames.
+///
+void checkManySets()
+{
+  AS1130RamPlanner planner;
+  planner.setPictureCount(6);
+  planner.setPwmSetCount(6);
+  check(planner.plan(), "six pictures with six sets");
+  check(planner.getRamConfiguration() == AS1130::RamConfiguration6, "configuration with six sets");
+  planner.setPictureCount(7);
+  check(!planner.plan(), "seven pictures do not fit six sets");
+  check(planner.getNonResidentCount() == 1, "one item not resident");
+}
+
+
+/// Content which does not fit keeps the most items resident.
+///
+void checkNonResident()
+{
+  const uint8_t frameCounts[] = {30, 10, 4, 4};
+  AS1130RamPlanner planner;
+  planner.setAnimations(frameCounts, 4);
+  planner.setPictureCount(2);
+  planner.setPwmSetCount(3);
+  check(!planner.plan(), "content does not fit");
+  check(planner.getNonResidentCount() == 1, "only the largest animation is not resident");
+  check(planner.getRamConfiguration() == AS1130::RamConfiguration3, "configuration with all sets");
+  check(planner.getAnimationFrameIndex(0) == -1, "largest animation not resident");
+  checkLayout(planner, frameCounts, 4, 2, false, "partial layout");
+}
+
+
+}
+
+
+int main()
+{
+  checkResident();
+  checkManySets();
+  checkNonResident();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
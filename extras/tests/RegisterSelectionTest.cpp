@@ -0,0 +1,126 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for the register selection cache of AS1130, using the simulated chip.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/RegisterSelectionTest.cpp LRAS1130*.cpp -o selection-test && ./selection-test
+//
+#include "LRAS1130.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Writes to the same register bank only select the bank once.
+///
+void checkRedundantSelection()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.writeToMemory(AS1130::RS_Control, AS1130::CR_CurrentSource, 0x10);
+  check(chip.getRegisterSelection() == AS1130::RS_Control, "first write selects the control registers");
+  bus.resetCounters();
+  driver.writeToMemory(AS1130::RS_Control, AS1130::CR_CurrentSource, 0x20);
+  driver.writeToMemory(AS1130::RS_Control, AS1130::CR_DisplayOption, 0x0b);
+  check(bus.getMessageCount() == 2, "repeated writes to the same bank skip the selection");
+  check(chip.getControlRegister(AS1130::CR_CurrentSource) == 0x20, "current source written");
+  check(chip.getControlRegister(AS1130::CR_DisplayOption) == 0x0b, "display option written");
+  bus.resetCounters();
+  driver.writeToMemory(AS1130::RS_OnOffFrame, 0x00, 0xff);
+  check(bus.getMessageCount() == 2, "a different bank is selected again");
+  check(chip.getOnOffFrame(0)[0] == 0xff, "frame written to the new bank");
+}
+
+
+/// A failed transfer invalidates the cached selection.
+///
+void checkFailedTransfer()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.writeToMemory(AS1130::RS_OnOffFrame, 0x00, 0x01);
+  chip.setConnected(false);
+  driver.writeToMemory(AS1130::RS_Control, AS1130::CR_CurrentSource, 0x10);
+  chip.setConnected(true);
+  driver.writeToMemory(AS1130::RS_OnOffFrame, 0x01, 0x02);
+  check(chip.getOnOffFrame(0)[1] == 0x02, "selection written again after a failed transfer");
+}
+
+
+/// A power on reset between two driver calls is detected and recovered.
+///
+void checkPowerOnReset()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.setControlRegisterShadowEnabled(true);
+  driver.setCurrentSource(AS1130::Current10mA);
+  check(driver.getInterruptStatus() == 0, "no interrupt before the reset");
+  chip.powerOnReset();
+  check(chip.getRegisterSelection() == AS1130::RS_NOP, "the reset clears the chip selection");
+  const uint8_t status = driver.getInterruptStatus();
+  check((status & AS1130::IMF_POR) != 0, "the power on reset is reported");
+  driver.setControlRegisterBits(AS1130::CR_Config, AS1130::CF_LowVddReset);
+  check(chip.getControlRegister(AS1130::CR_Config) == AS1130::CF_LowVddReset, "the shadow was read from the reset chip");
+  driver.setOnOffFrameAllOn(0);
+  check(chip.getOnOffFrame(0)[0] == 0xff, "frames are written to the right bank after the reset");
+  check(chip.getControlRegister(AS1130::CR_CurrentSource) == 0, "the current source was cleared by the reset");
+}
+
+
+}
+
+
+int main()
+{
+  checkRedundantSelection();
+  checkFailedTransfer();
+  checkPowerOnReset();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
@@ -0,0 +1,152 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for the simulated AS1130 chip and bus.
+//
+// Build and run from the library directory:
+//   g++ -std=c++11 -I. extras/tests/SimulatorTest.cpp LRAS1130*.cpp -o simulator-test && ./simulator-test
+//
+#include "LRAS1130.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// Bursts increment the address, the selection persists between transfers.
+///
+void checkMemoryAccess()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip(AS1130::ChipAddress3);
+  bus.attachChip(chip);
+  const uint8_t selection = AS1130::RS_OnOffFrame + 2;
+  const uint8_t data[] = {0x11, 0x22, 0x33};
+  AS1130Bus::Message select = AS1130Bus::Message::write(0xfd, &selection, 1);
+  check(bus.transfer(AS1130::ChipAddress3, &select, 1), "selection acknowledged");
+  AS1130Bus::Message write = AS1130Bus::Message::write(0x04, data, sizeof(data));
+  check(bus.transfer(AS1130::ChipAddress3, &write, 1), "burst acknowledged");
+  check(chip.getRegisterSelection() == selection, "selection persists");
+  check(chip.getOnOffFrame(2)[4] == 0x11 && chip.getOnOffFrame(2)[6] == 0x33, "burst written with auto increment");
+  uint8_t readData[2] = {0, 0};
+  const AS1130Bus::Message read[] = {
+    AS1130Bus::Message::write(0x05, nullptr, 0),
+    AS1130Bus::Message::read(readData, sizeof(readData))};
+  check(bus.transfer(AS1130::ChipAddress3, read, 2), "read acknowledged");
+  check(readData[0] == 0x22 && readData[1] == 0x33, "read from the address pointer");
+  const AS1130Bus::Message pointer = AS1130Bus::Message::write(0xfd, nullptr, 0);
+  check(bus.transfer(AS1130::ChipAddress3, &pointer, 1), "pointer write acknowledged");
+  check(chip.getRegisterSelection() == selection, "a pointer write keeps the selection");
+}
+
+
+/// Missing or disconnected chips and oversized messages are not acknowledged.
+///
+void checkAcknowledge()
+{
+  AS1130SimulatorBus bus(4);
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  const uint8_t data[5] = {0, 0, 0, 0, 0};
+  const AS1130Bus::Message small = AS1130Bus::Message::write(0x00, data, 4);
+  const AS1130Bus::Message large = AS1130Bus::Message::write(0x00, data, 5);
+  check(bus.transfer(AS1130::ChipAddress0, &small, 1), "message within the limit");
+  check(!bus.transfer(AS1130::ChipAddress0, &large, 1), "message above the limit");
+  check(!bus.transfer(AS1130::ChipAddress1, &small, 1), "no chip at the address");
+  chip.setConnected(false);
+  check(!bus.transfer(AS1130::ChipAddress0, &small, 1), "disconnected chip");
+  chip.setConnected(true);
+  bus.detachChip(chip);
+  check(!bus.transfer(AS1130::ChipAddress0, &small, 1), "detached chip");
+  check(bus.getTransferCount() == 5, "all transfers counted");
+}
+
+
+/// The movie advances with the simulated time.
+///
+void checkMovie()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.setMovieFrameCount(4);
+  driver.setFrameDelayMs(65);
+  driver.setMovieLoopCount(AS1130::MovieLoop1);
+  driver.startMovie(8);
+  driver.startChip();
+  check(driver.isMovieRunning(), "movie running");
+  check(driver.getDisplayedFrame() == 8, "movie starts at the first frame");
+  bus.advanceTime(65000);
+  check(driver.getDisplayedFrame() == 9, "one frame after the frame delay");
+  bus.delayMs(200);
+  check(!driver.isMovieRunning(), "movie stops after one loop");
+  check((driver.getInterruptStatus() & AS1130::IMF_MovieFinished) != 0, "finished movie reported");
+  check(driver.getInterruptStatus() == 0, "reading the status clears it");
+}
+
+
+/// A manual LED test reports the open LEDs.
+///
+void checkLedTest()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  chip.setLedOpen(0x23, true);
+  driver.runManualTest();
+  check(driver.getLedStatus(0x23) == AS1130::LedStatusOpen, "open LED reported");
+  check(driver.getLedStatus(0x24) == AS1130::LedStatusOk, "working LED reported");
+}
+
+
+}
+
+
+int main()
+{
+  checkMemoryAccess();
+  checkAcknowledge();
+  checkMovie();
+  checkLedTest();
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}
@@ -0,0 +1,94 @@
+//
+// Lucky Resistor's AS1130 Library
+// ---------------------------------------------------------------------------
+// (c)2017 by Lucky Resistor. See LICENSE for details.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>
+//
+//
+// Host test for the bus traffic statistics of AS1130, using the simulated chip.
+//
+// Build and run from the library directory, with the statistics enabled:
+//   g++ -std=c++11 -DLRAS1130_STATISTICS -I. extras/tests/StatisticsTest.cpp LRAS1130*.cpp -o statistics-test && ./statistics-test
+//
+#include "LRAS1130.h"
+#include "LRAS1130Simulator.h"
+
+#include <cstdio>
+
+
+using namespace lr;
+
+
+namespace {
+
+
+int gFailureCount = 0;
+
+
+void check(bool condition, const char *message)
+{
+  if (!condition) {
+    std::printf("FAILED: %s\n", message);
+    ++gFailureCount;
+  }
+}
+
+
+/// The counters match the traffic seen by the simulator bus.
+///
+void checkCounters()
+{
+  AS1130SimulatorBus bus;
+  AS1130SimulatedChip chip;
+  bus.attachChip(chip);
+  AS1130 driver(bus);
+  driver.setOnOffFrameAllOn(0);
+  driver.setOnOffFrameAllOn(1);
+  driver.setLowVddResetEnabled(true);
+  const AS1130::Statistics &statistics = driver.getStatistics();
+  check(statistics.transfers == bus.getTransferCount(), "transfers");
+  check(statistics.transactions == bus.getMessageCount(), "messages");
+  check(statistics.bytesWritten == bus.getBytesWritten(), "written bytes");
+  check(statistics.bytesRead == bus.getBytesRead(), "read bytes");
+  check(statistics.registerSelections == 3, "one selection for each bank change");
+  check(statistics.readModifyWriteReads == 1, "one read to change bits");
+  check(statistics.failedTransfers == 0, "no failed transfers");
+  check(statistics.busTimeUs == bus.getTimeUs(), "time on the bus");
+  chip.setConnected(false);
+  driver.setOnOffFrameAllOn(2);
+  check(statistics.failedTransfers == 1, "failed transfer counted");
+  driver.resetStatistics();
+  check(statistics.transfers == 0 && statistics.bytesWritten == 0, "counters reset");
+}
+
+
+}
+
+
+int main()
+{
+#if defined(LRAS1130_STATISTICS)
+  checkCounters();
+#else
+  std::printf("FAILED: compile this test with LRAS1130_STATISTICS defined\n");
+  ++gFailureCount;
+#endif
+  if (gFailureCount == 0) {
+    std::printf("OK\n");
+    return 0;
+  }
+  std::printf("%d checks failed\n", gFailureCount);
+  return 1;
+}